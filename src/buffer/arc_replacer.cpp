@@ -0,0 +1,260 @@
+/**
+ * ARC implementation
+ */
+#include <algorithm>
+#include <cassert>
+
+#include "buffer/arc_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+    namespace {
+        // key under which a value and its ghost are tracked
+        inline page_id_t GhostKey(Page *const &page) { return page->GetPageId(); }
+
+        inline page_id_t GhostKey(const int &value) { return value; }
+    } // namespace
+
+    template<typename T>
+    ARCReplacer<T>::ARCReplacer(size_t capacity)
+            : capacity_(capacity == 0 ? 1 : capacity), target_(0), size_(0),
+              evictable_{0, 0} {}
+
+    template<typename T>
+    ARCReplacer<T>::~ARCReplacer() {}
+
+/*
+ * Record one access of value and make it evictable. A cached value moves to
+ * the MRU end of T2, a ghost adapts the target size of T1 and comes back into
+ * T2, anything else enters T1
+ */
+    template<typename T>
+    void ARCReplacer<T>::Insert(const T &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        page_id_t key = GhostKey(value);
+        auto iter = entries_.find(key);
+        if (iter == entries_.end()) {
+            Entry &entry = entries_[key];
+            entry.list = T1;
+            entry.pos = lists_[T1].insert(lists_[T1].end(), key);
+            entry.value = value;
+            entry.evictable = true;
+            evictable_[T1]++;
+            size_++;
+            if (lists_[T1].size() + lists_[T2].size() > capacity_) {
+                PurgeStale();
+            }
+            Trim();
+            return;
+        }
+
+        Entry &entry = iter->second;
+        if (entry.prefetched) {
+            // the first real access, value stays in T1
+            entry.prefetched = false;
+            if (entry.evictable) {
+                evictable_[T1]--;
+                size_--;
+            }
+            MoveTo(key, entry, T1);
+            entry.value = value;
+            entry.evictable = true;
+            evictable_[T1]++;
+            size_++;
+            return;
+        }
+        if (entry.list == B1) {
+            size_t delta = std::max<size_t>(1, lists_[B2].size() / lists_[B1].size());
+            target_ = std::min(capacity_, target_ + delta);
+        } else if (entry.list == B2) {
+            size_t delta = std::max<size_t>(1, lists_[B1].size() / lists_[B2].size());
+            target_ = target_ > delta ? target_ - delta : 0;
+        }
+        if ((entry.list == T1 || entry.list == T2) && entry.evictable) {
+            evictable_[entry.list]--;
+            size_--;
+        }
+        MoveTo(key, entry, T2);
+        entry.value = value;
+        entry.evictable = true;
+        evictable_[T2]++;
+        size_++;
+        Trim();
+    }
+
+/*
+ * Make value evictable at the MRU end of T1 without counting an access. A
+ * value already cached keeps its place, a ghost is revived into T1 without
+ * adapting the target size
+ */
+    template<typename T>
+    void ARCReplacer<T>::InsertPrefetched(const T &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        page_id_t key = GhostKey(value);
+        auto iter = entries_.find(key);
+        if (iter != entries_.end() &&
+            (iter->second.list == T1 || iter->second.list == T2)) {
+            Entry &entry = iter->second;
+            entry.value = value;
+            if (!entry.evictable) {
+                entry.evictable = true;
+                evictable_[entry.list]++;
+                size_++;
+            }
+            return;
+        }
+        Entry &entry = entries_[key];
+        if (iter == entries_.end()) {
+            entry.pos = lists_[T1].insert(lists_[T1].end(), key);
+            entry.list = T1;
+        } else {
+            MoveTo(key, entry, T1);
+        }
+        entry.value = value;
+        entry.evictable = true;
+        entry.prefetched = true;
+        evictable_[T1]++;
+        size_++;
+        if (lists_[T1].size() + lists_[T2].size() > capacity_) {
+            PurgeStale();
+        }
+        Trim();
+    }
+
+/* Evict the least recently used evictable value of T1 if T1 is above its
+ * target size, of T2 otherwise, falling back to the other list when every
+ * value there is pinned. The victim leaves a ghost behind unless it was
+ * prefetched and never accessed. If nothing is evictable, return false
+ */
+    template<typename T>
+    bool ARCReplacer<T>::Victim(T &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        if (size_ == 0) {
+            return false;
+        }
+        ListId from = T2;
+        if (evictable_[T1] > 0 &&
+            (lists_[T1].size() > target_ || evictable_[T2] == 0)) {
+            from = T1;
+        }
+        for (page_id_t key : lists_[from]) {
+            Entry &entry = entries_[key];
+            if (!entry.evictable) {
+                continue;
+            }
+            value = entry.value;
+            entry.evictable = false;
+            entry.value = T();
+            evictable_[from]--;
+            size_--;
+            if (entry.prefetched) {
+                // read ahead but never used, no ghost to learn from
+                lists_[from].erase(entry.pos);
+                entries_.erase(key);
+                return true;
+            }
+            MoveTo(key, entry, from == T1 ? B1 : B2);
+            Trim();
+            return true;
+        }
+        assert(false);
+        return false;
+    }
+
+/*
+ * Pin value in place. If removal is successful, return true, otherwise return
+ * false
+ */
+    template<typename T>
+    bool ARCReplacer<T>::Erase(const T &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        auto iter = entries_.find(GhostKey(value));
+        if (iter == entries_.end() || !iter->second.evictable) {
+            return false;
+        }
+        iter->second.evictable = false;
+        evictable_[iter->second.list]--;
+        size_--;
+        return true;
+    }
+
+    template<typename T>
+    size_t ARCReplacer<T>::Size() {
+        std::lock_guard<std::mutex> lck(latch);
+        return size_;
+    }
+
+    template<typename T>
+    size_t ARCReplacer<T>::GetTarget() {
+        std::lock_guard<std::mutex> lck(latch);
+        return target_;
+    }
+
+/*
+ * unlink key from its current list and append it at the MRU end of list
+ * caller must hold latch
+ */
+    template<typename T>
+    void ARCReplacer<T>::MoveTo(page_id_t key, Entry &entry, ListId list) {
+        lists_[entry.list].erase(entry.pos);
+        entry.list = list;
+        entry.pos = lists_[list].insert(lists_[list].end(), key);
+    }
+
+/*
+ * forget the least recently used ghost of list
+ * caller must hold latch
+ */
+    template<typename T>
+    void ARCReplacer<T>::Drop(ListId list) {
+        entries_.erase(lists_[list].front());
+        lists_[list].pop_front();
+    }
+
+/*
+ * bound the directory: |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c
+ * caller must hold latch
+ */
+    template<typename T>
+    void ARCReplacer<T>::Trim() {
+        while (lists_[T1].size() + lists_[B1].size() > capacity_ &&
+               !lists_[B1].empty()) {
+            Drop(B1);
+        }
+        while (entries_.size() > 2 * capacity_ && !lists_[B2].empty()) {
+            Drop(B2);
+        }
+        while (entries_.size() > 2 * capacity_ && !lists_[B1].empty()) {
+            Drop(B1);
+        }
+    }
+
+/*
+ * DeletePage only pins the entry of a deleted page, so its frame may since
+ * hold another page. Such entries are dropped once T1 and T2 track more pages
+ * than there are frames. caller must hold latch
+ */
+    template<typename T>
+    void ARCReplacer<T>::PurgeStale() {
+        for (ListId list : {T1, T2}) {
+            for (auto iter = lists_[list].begin(); iter != lists_[list].end();) {
+                Entry &entry = entries_[*iter];
+                if (!entry.evictable && GhostKey(entry.value) != *iter) {
+                    entries_.erase(*iter);
+                    iter = lists_[list].erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+        }
+    }
+
+    template
+    class ARCReplacer<Page *>;
+
+// test only
+    template
+    class ARCReplacer<int>;
+
+} // namespace cmudb
@@ -1,3 +1,8 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 
 namespace cmudb {
@@ -5,34 +10,76 @@ namespace cmudb {
     /**
      * BufferPoolManager Constructor
      * When log_manager is nullptr, logging is disabled (for test purpose)
-     * WARNING: Do Not Edit This Function
+     * num_instances: number of independent partitions the frames are split
+     * into. A page is always cached by the instance GetInstance() picks for it.
+     * replacer_type: replacement policy of every instance
      */
     BufferPoolManager::BufferPoolManager(size_t pool_size,
                                          DiskManager *disk_manager,
-                                         LogManager *log_manager)
-            : pool_size_(pool_size), disk_manager_(disk_manager),
-              log_manager_(log_manager) {
-        // a consecutive memory space for buffer pool
-        pages_ = new Page[pool_size_];
-        page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-        replacer_ = new LRUReplacer<Page *>;
-        free_list_ = new std::list<Page *>;
+                                         LogManager *log_manager,
+                                         size_t num_instances,
+                                         ReplacerType replacer_type)
+            : pool_size_(pool_size), page_size_(disk_manager->GetPageSize()),
+              num_instances_(num_instances),
+              replacer_type_(replacer_type), disk_manager_(disk_manager), log_manager_(log_manager),
+              flush_thread_(nullptr), flush_running_(false), foreground_writes_(0),
+              background_writes_(0), prefetch_thread_(nullptr), prefetch_running_(false),
+              read_ahead_window_(READ_AHEAD_WINDOW), prefetched_pages_(0),
+              access_clock_(0), warm_up_thread_(nullptr), warm_up_stop_(false),
+              warm_up_stats_{0, std::chrono::microseconds(0), false} {
+        // every instance needs at least one frame
+        if (num_instances_ == 0) {
+            num_instances_ = 1;
+        }
+        if (num_instances_ > pool_size_ && pool_size_ > 0) {
+            num_instances_ = pool_size_;
+        }
+        instances_ = new BufferPoolInstance[num_instances_];
+        frame_region_ = new FrameRegion(pool_size_, page_size_, BUFFER_POOL_HUGE_PAGES,
+                                        BUFFER_POOL_NUMA_NODE);
+        compressed_tier_ = nullptr;
+        if (BUFFER_POOL_COMPRESSED_TIER_BUDGET > 0) {
+            compressed_tier_ = new CompressedTier(BUFFER_POOL_COMPRESSED_TIER_BUDGET,
+                                                  page_size_);
+        }
+        size_t first_frame = 0;
+        for (size_t i = 0; i < num_instances_; ++i) {
+            BufferPoolInstance &instance = instances_[i];
+            instance.pool_size_ = pool_size_ / num_instances_ +
+                                  (i < pool_size_ % num_instances_ ? 1 : 0);
+            // a consecutive memory space for each instance
+            instance.pages_ = new Page[instance.pool_size_];
+            instance.page_table_ = new LockFreeHashTable<page_id_t, Page *>(instance.pool_size_);
+            instance.replacer_ = NewReplacer(instance);
+            instance.free_list_ = new std::list<Page *>;
 
-        // put all the pages into free list
-        for (size_t i = 0; i < pool_size_; ++i) {
-            free_list_->push_back(&pages_[i]);
+            // put all the pages into free list
+            for (size_t j = 0; j < instance.pool_size_; ++j) {
+                instance.pages_[j].data_ = frame_region_->GetFrame(first_frame + j);
+                instance.pages_[j].page_size_ = page_size_;
+                instance.free_list_->push_back(&instance.pages_[j]);
+            }
+            first_frame += instance.pool_size_;
         }
     }
 
     /**
      * BufferPoolManager Deconstructor
-     * WARNING: Do Not Edit This Function
      */
     BufferPoolManager::~BufferPoolManager() {
-        delete[] pages_;
-        delete page_table_;
-        delete replacer_;
-        delete free_list_;
+        warm_up_stop_ = true;
+        WaitForWarmUp();
+        StopPrefetchThread();
+        StopFlushThread();
+        for (size_t i = 0; i < num_instances_; ++i) {
+            delete[] instances_[i].pages_;
+            delete instances_[i].page_table_;
+            delete instances_[i].replacer_;
+            delete instances_[i].free_list_;
+        }
+        delete[] instances_;
+        delete frame_region_;
+        delete compressed_tier_;
     }
 
     /**
@@ -45,26 +92,108 @@ namespace cmudb {
      * entry for the new page.
      * 4. Update page metadata, read page content from disk file and return page
      * pointer
+     * The read runs without the instance latch: the frame is marked is_loading_
+     * and write latched before it gets its pin and its page table entry, so
+     * concurrent fetchers of the page, TryPinFast included, wait on the frame
+     * latch only and never see it unloaded
+     * A page that is resident and already pinned is pinned again without the
+     * instance latch (see TryPinFast)
+     * The compressed tier, if any, is asked before the disk (see ReadFrame)
      */
     Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-        lock_guard<mutex> lck(latch_);
+        BufferPoolInstance &instance = GetInstance(page_id);
         Page *page = nullptr;
-        if (page_table_->Find(page_id, page)) {
-            page->pin_count_++;
-            replacer_->Erase(page);
+        if (instance.page_table_->Find(page_id, page) &&
+            TryPinFast(instance, page, page_id)) {
+            instance.hits_++;
             return page;
         }
-        page = GetFreeOrUnPinnedPage();
+        unique_lock<TimedMutex> lck(instance.latch_);
+        if (instance.page_table_->Find(page_id, page)) {
+            instance.hits_++;
+            return PinResident(instance, page, lck);
+        }
+        page = GetFreeOrUnPinnedPage(instance, lck);
         if (page == nullptr) {
             return nullptr;
         }
-        page_table_->Remove(page->GetPageId());
-        page_table_->Insert(page_id, page);
-
-        disk_manager_->ReadPage(page_id, page->data_);
+        // the latch may have been released while waiting for a background
+        // write, another thread could have loaded the page in the meantime
+        Page *loaded = nullptr;
+        if (instance.page_table_->Find(page_id, loaded)) {
+            instance.page_table_->Remove(page->GetPageId());
+            page->page_id_ = INVALID_PAGE_ID;
+            page->is_dirty_ = false;
+            instance.free_list_->push_back(page);
+            instance.hits_++;
+            return PinResident(instance, loaded, lck);
+        }
+        instance.page_table_->Remove(page->GetPageId());
         page->page_id_ = page_id;
         page->is_dirty_ = false;
+        page->is_loading_ = true;
+        page->WLatch();
         page->pin_count_ = 1;
+        instance.page_table_->Insert(page_id, page);
+        instance.misses_++;
+        lck.unlock();
+
+        ReadFrame(page_id, page);
+
+        lck.lock();
+        page->is_loading_ = false;
+        lck.unlock();
+        page->WUnlatch();
+        return page;
+    }
+
+    /**
+     * pin page, looked up for page_id without the latch, if somebody else
+     * holds a pin on it already: then it cannot be evicted, the pin count only
+     * needs an atomic increment and the replacer is not involved. The frame
+     * may have been reused for another page between the lookup and the pin,
+     * which the page id check after pinning catches. Returns false when the
+     * caller has to take the latched path
+     */
+    bool BufferPoolManager::TryPinFast(BufferPoolInstance &instance, Page *page,
+                                       page_id_t page_id) {
+        int pin_count = page->pin_count_.load();
+        do {
+            if (pin_count <= 0) {
+                return false;
+            }
+        } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+        if (page->page_id_ != page_id) {
+            lock_guard<TimedMutex> lck(instance.latch_);
+            if (--page->pin_count_ == 0) {
+                instance.replacer_->Insert(page);
+            }
+            return false;
+        }
+        if (page->is_loading_) {
+            // same as PinResident, the loader holds the write latch
+            instance.pin_waits_++;
+            page->RLatch();
+            page->RUnlatch();
+        }
+        return true;
+    }
+
+    /**
+     * pin a page found in the page table, waiting for its read if it is still
+     * being loaded (in which case lck is released)
+     * caller must hold instance.latch_ through lck
+     */
+    Page *BufferPoolManager::PinResident(BufferPoolInstance &instance, Page *page,
+                                         unique_lock<TimedMutex> &lck) {
+        page->pin_count_++;
+        instance.replacer_->Erase(page);
+        if (page->is_loading_) {
+            instance.pin_waits_++;
+            lck.unlock();
+            page->RLatch();
+            page->RUnlatch();
+        }
         return page;
     }
 
@@ -73,21 +202,39 @@ namespace cmudb {
      * if pin_count>0, decrement it and if it becomes zero, put it back to
      * replacer if pin_count<=0 before this call, return false. is_dirty: set the
      * dirty flag of this page
+     * An unpin that leaves other pins in place does not take the latch: the
+     * caller's own pin keeps the frame from being reused meanwhile
      */
     bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-        lock_guard<mutex> lck(latch_);
+        BufferPoolInstance &instance = GetInstance(page_id);
         Page *page = nullptr;
-        if (!page_table_->Find(page_id, page) || page == nullptr) {
+        if (instance.page_table_->Find(page_id, page) && page->page_id_ == page_id) {
+            int pin_count = page->pin_count_.load();
+            while (pin_count > 1) {
+                if (is_dirty) {
+                    page->is_dirty_ = true;
+                }
+                if (page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1)) {
+                    return true;
+                }
+            }
+        }
+        lock_guard<TimedMutex> lck(instance.latch_);
+        if (!instance.page_table_->Find(page_id, page) || page == nullptr) {
             return false;
         }
-        page->is_dirty_ = is_dirty;
+        // a clean unpin must not hide changes of an earlier writer
+        if (is_dirty) {
+            page->is_dirty_ = true;
+        }
 
         // don't understand why the comment would say pin_count can be less than 0
         if (page->pin_count_ <= 0) {
             return false;
         }
         if (--page->pin_count_ == 0) {
-            replacer_->Insert(page);
+            page->last_used_ = ++access_clock_;
+            instance.replacer_->Insert(page);
         }
         return true;
     }
@@ -96,22 +243,168 @@ namespace cmudb {
      * Used to flush a particular page of the buffer pool to disk. Should call the
      * write_page method of the disk manager
      * if page is not found in page table, return false
+     * The page only reaches the OS cache, it is not synced: FlushAllPages
+     * makes pages durable
      * NOTE: make sure page_id != INVALID_PAGE_ID
      */
     bool BufferPoolManager::FlushPage(page_id_t page_id) {
-        lock_guard<mutex> lck(latch_);
+        if (page_id == INVALID_PAGE_ID) {
+            return false;
+        }
+        BufferPoolInstance &instance = GetInstance(page_id);
+        unique_lock<TimedMutex> lck(instance.latch_);
         Page *page = nullptr;
-        // don't understand why the comment would say page_id can be equals to INVALID_PAGE_ID
-        if (!page_table_->Find(page_id, page) || page == nullptr || page->GetPageId() == INVALID_PAGE_ID) {
+        // a background write of the page has to land before we return
+        while (instance.page_table_->Find(page_id, page) && page->is_flushing_) {
+            WaitForFlush(instance, page, lck);
+        }
+        if (!instance.page_table_->Find(page_id, page) || page == nullptr) {
             return false;
         }
         if (page->is_dirty_) {
             disk_manager_->WritePage(page->GetPageId(), page->GetData());
+            foreground_writes_++;
             page->is_dirty_ = false;
         }
         return true;
     }
 
+    /**
+     * Flush every dirty page of the pool, pinned or not, and return once all
+     * of them are on disk. Dirty frames are marked is_flushing_ one at a time
+     * under the instance latch, so evicting or deleting them waits for the
+     * write, and copied under their read latch with the instance latch
+     * released, as FlushInstance does. The copies are sorted by page id and
+     * handed to the disk manager as one batch. If a writer holds a page, the
+     * copies taken so far are written first: the writer may be waiting for
+     * one of them. Frames the background flusher is writing are waited for.
+     * Pages whose LSN is beyond the persisted log are skipped and stay dirty
+     * (WAL). Then the file is synced once, which covers the background
+     * writes waited for too; a failed sync is reported in synced.
+     * Pages deleted before the checkpoint started are freed on disk only if
+     * every page dirty at that point made it into the sync: the pages that
+     * pointed to them are durable then.
+     */
+    FlushStats BufferPoolManager::FlushAllPages() {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<page_id_t> deleted = disk_manager_->TakeDeallocatedPages();
+        bool complete = true; // no dirty page was skipped
+        // frames of every instance, written by us or by the background flusher
+        std::vector<std::vector<Page *>> batch(num_instances_);
+        std::vector<std::vector<Page *>> in_flight(num_instances_);
+        std::vector<std::pair<page_id_t, size_t>> order; // page id, copy index
+        std::vector<char> copies;
+        size_t pages_flushed = 0;
+
+        auto write_batch = [&] {
+            // sequential I/O: one pass over the file in page id order
+            std::sort(order.begin(), order.end());
+            std::vector<std::pair<page_id_t, const char *>> writes;
+            writes.reserve(order.size());
+            for (auto &entry : order) {
+                writes.emplace_back(entry.first, copies.data() + entry.second * page_size_);
+            }
+            disk_manager_->WritePages(writes);
+            foreground_writes_ += writes.size();
+            pages_flushed += writes.size();
+            for (size_t i = 0; i < num_instances_; ++i) {
+                if (batch[i].empty()) {
+                    continue;
+                }
+                BufferPoolInstance &instance = instances_[i];
+                {
+                    lock_guard<TimedMutex> lck(instance.latch_);
+                    for (Page *page : batch[i]) {
+                        page->is_flushing_ = false;
+                    }
+                }
+                instance.flush_cv_.notify_all();
+                batch[i].clear();
+            }
+            order.clear();
+            copies.clear();
+        };
+
+        for (size_t i = 0; i < num_instances_; ++i) {
+            BufferPoolInstance &instance = instances_[i];
+            std::vector<Page *> dirty;
+            {
+                lock_guard<TimedMutex> lck(instance.latch_);
+                for (size_t j = 0; j < instance.pool_size_; ++j) {
+                    Page *page = &instance.pages_[j];
+                    if (page->page_id_ == INVALID_PAGE_ID) {
+                        continue;
+                    }
+                    if (page->is_flushing_) {
+                        in_flight[i].push_back(page);
+                    } else if (page->is_dirty_) {
+                        dirty.push_back(page);
+                    }
+                }
+            }
+            for (Page *page : dirty) {
+                page_id_t page_id;
+                {
+                    lock_guard<TimedMutex> lck(instance.latch_);
+                    page_id = page->page_id_;
+                    if (page_id == INVALID_PAGE_ID || !page->is_dirty_) {
+                        continue;
+                    }
+                    if (page->is_flushing_) {
+                        in_flight[i].push_back(page);
+                        continue;
+                    }
+                    if (!IsLogPersisted(page)) {
+                        complete = false;
+                        continue;
+                    }
+                    page->is_flushing_ = true;
+                }
+                if (!page->TryRLatch()) {
+                    write_batch();
+                    page->RLatch();
+                }
+                // the LSN may have moved while we waited for the latch
+                bool persisted = IsLogPersisted(page);
+                if (persisted) {
+                    page->is_dirty_ = false;
+                    batch[i].push_back(page);
+                    order.emplace_back(page_id, order.size());
+                    copies.insert(copies.end(), page->data_, page->data_ + page_size_);
+                }
+                page->RUnlatch();
+                if (!persisted) {
+                    complete = false;
+                    {
+                        lock_guard<TimedMutex> lck(instance.latch_);
+                        page->is_flushing_ = false;
+                    }
+                    instance.flush_cv_.notify_all();
+                }
+            }
+        }
+        write_batch();
+
+        for (size_t i = 0; i < num_instances_; ++i) {
+            BufferPoolInstance &instance = instances_[i];
+            unique_lock<TimedMutex> lck(instance.latch_);
+            for (Page *page : in_flight[i]) {
+                WaitForFlush(instance, page, lck);
+                // a failed or skipped background write, or a new change:
+                // we cannot tell, so assume the worst
+                if (page->is_dirty_) {
+                    complete = false;
+                }
+            }
+        }
+        bool synced = disk_manager_->SyncPages();
+        disk_manager_->FreeDeallocatedPages(deleted, synced && complete);
+        return FlushStats{pages_flushed,
+                          std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::steady_clock::now() - start),
+                          synced};
+    }
+
     /**
      * User should call this method for deleting a page. This routine will call
      * disk manager to deallocate the page. First, if page is found within page
@@ -119,23 +412,45 @@ namespace cmudb {
      * of page table, reseting page metadata and adding back to free list. Second,
      * call disk manager's DeallocatePage() method to delete from disk file. If
      * the page is found within page table, but pin_count != 0, return false
+     * The disk manager frees the page at the next checkpoint.
      */
     bool BufferPoolManager::DeletePage(page_id_t page_id) {
-        lock_guard<mutex> lck(latch_);
+        return DropPage(page_id, true);
+    }
+
+    /**
+     * DeletePage; referenced is false for a page that was never handed out,
+     * which the disk manager frees right away
+     */
+    bool BufferPoolManager::DropPage(page_id_t page_id, bool referenced) {
+        BufferPoolInstance &instance = GetInstance(page_id);
+        unique_lock<TimedMutex> lck(instance.latch_);
         Page *page = nullptr;
-        page_table_->Find(page_id, page);
+        instance.page_table_->Find(page_id, page);
         if (page != nullptr) {
             if (page->GetPinCount() > 0) {
                 return false;
             }
-            page_table_->Remove(page_id);
-            replacer_->Erase(page);
+            if (page->is_flushing_) {
+                // hold a pin so that nobody evicts the frame while we wait
+                page->pin_count_++;
+                instance.replacer_->Erase(page);
+                WaitForFlush(instance, page, lck);
+                if (--page->pin_count_ > 0) {
+                    return false;
+                }
+            }
+            instance.page_table_->Remove(page_id);
+            instance.replacer_->Erase(page);
             page->ResetMemory();
             page->is_dirty_ = false;
             page->page_id_ = INVALID_PAGE_ID;
-            free_list_->push_back(page);
+            instance.free_list_->push_back(page);
+        }
+        if (compressed_tier_ != nullptr) {
+            compressed_tier_->Erase(page_id);
         }
-        disk_manager_->DeallocatePage(page_id);
+        disk_manager_->DeallocatePage(page_id, referenced);
         return true;
     }
 
@@ -146,47 +461,663 @@ namespace cmudb {
      * from free list or lru replacer(NOTE: always choose from free list first),
      * update new page's metadata, zero out memory and add corresponding entry
      * into page table. return nullptr if all the pages in pool are pinned
+     * The page id is allocated first because it decides which instance has to
+     * host the page; if that instance is fully pinned the id is given back.
+     * The header page is formatted on allocation so that it records the page
+     * size of the file. near_page_id asks for a page close to it on disk.
      */
-    Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-        Page *page = GetFreeOrUnPinnedPage();
+    Page *BufferPoolManager::NewPage(page_id_t &page_id, page_id_t near_page_id) {
+        page_id_t new_page_id = disk_manager_->AllocatePage(near_page_id);
+        BufferPoolInstance &instance = GetInstance(new_page_id);
+        unique_lock<TimedMutex> lck(instance.latch_);
+        Page *page = InstallNewPage(instance, new_page_id, lck);
         if (page == nullptr) {
+            disk_manager_->DeallocatePage(new_page_id, false);
             return nullptr;
         }
-        page_table_->Remove(page->GetPageId());
-        page_table_->Insert(page_id, page);
-        page_id = disk_manager_->AllocatePage();
-        page->ResetMemory();
-        page->page_id_ = page_id;
-        page->is_dirty_ = false;
-        page->pin_count_ = 1;
+        page_id = new_page_id;
         return page;
     }
 
+    /**
+     * Bulk load variant of NewPage: allocate count consecutive page ids with
+     * one call to the disk manager and create all of them pinned, taking the
+     * latch of each instance once. pages receives them in page id order.
+     * All or nothing: if the pool cannot hold every new page pinned at once,
+     * the pages created so far are dropped again and false is returned
+     */
+    bool BufferPoolManager::NewPages(size_t count, page_id_t &first_page_id,
+                                     std::vector<Page *> &pages) {
+        pages.assign(count, nullptr);
+        if (count == 0) {
+            return true;
+        }
+        page_id_t first = disk_manager_->AllocatePages(count);
+        bool ok = true;
+        for (size_t i = 0; i < num_instances_ && i < count && ok; ++i) {
+            // ids first + k with k = i, i + num_instances_, ... share an instance
+            BufferPoolInstance &instance = GetInstance(first + static_cast<page_id_t>(i));
+            unique_lock<TimedMutex> lck(instance.latch_);
+            for (size_t k = i; k < count; k += num_instances_) {
+                pages[k] = InstallNewPage(instance, first + static_cast<page_id_t>(k), lck);
+                if (pages[k] == nullptr) {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        if (!ok) {
+            // last page first, so that the ids go back to the end of the file
+            for (size_t k = count; k-- > 0;) {
+                page_id_t page_id = first + static_cast<page_id_t>(k);
+                if (pages[k] != nullptr) {
+                    UnpinPage(page_id, false);
+                    DropPage(page_id, false);
+                } else {
+                    disk_manager_->DeallocatePage(page_id, false);
+                }
+            }
+            pages.clear();
+            return false;
+        }
+        first_page_id = first;
+        return true;
+    }
+
+    /*
+     * Guarded variants of FetchPage and NewPage: the page is pinned once and
+     * latched in the guard's mode; the guard unlatches and unpins it. The
+     * guard is empty if the page could not be brought in
+     */
+    ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id) {
+        return ReadPageGuard(this, FetchPage(page_id));
+    }
+
+    WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+        return WritePageGuard(this, FetchPage(page_id));
+    }
+
+    WritePageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id,
+                                                     page_id_t near_page_id) {
+        WritePageGuard guard(this, NewPage(page_id, near_page_id));
+        // a new page has to reach the disk even if the caller leaves it zeroed
+        if (guard.IsValid()) {
+            guard.MarkDirty();
+        }
+        return guard;
+    }
+
+    /**
+     * map the freshly allocated page_id to a free or evicted frame, zeroed
+     * and pinned once. nullptr if every frame of the instance is pinned
+     * caller must hold instance.latch_ through lck
+     */
+    Page *BufferPoolManager::InstallNewPage(BufferPoolInstance &instance, page_id_t page_id,
+                                            unique_lock<TimedMutex> &lck) {
+        Page *page = GetFreeOrUnPinnedPage(instance, lck);
+        if (page == nullptr) {
+            return nullptr;
+        }
+        // a prefetch racing with the allocation may have cached the fresh id
+        // already, adopt that frame; the prefetcher drops its own pin later
+        Page *prefetched = nullptr;
+        if (instance.page_table_->Find(page_id, prefetched)) {
+            instance.page_table_->Remove(page->GetPageId());
+            page->page_id_ = INVALID_PAGE_ID;
+            page->is_dirty_ = false;
+            instance.free_list_->push_back(page);
+            page = PinResident(instance, prefetched, lck);
+            if (!lck.owns_lock()) {
+                lck.lock();
+            }
+            page->ResetMemory();
+        } else {
+            instance.page_table_->Remove(page->GetPageId());
+            instance.page_table_->Insert(page_id, page);
+            page->ResetMemory();
+            page->page_id_ = page_id;
+            page->is_dirty_ = false;
+            page->pin_count_ = 1;
+        }
+        if (page_id == HEADER_PAGE_ID) {
+            static_cast<HeaderPage *>(page)->Init();
+        }
+        // the tier may still hold a page that was deleted under this id
+        if (compressed_tier_ != nullptr) {
+            compressed_tier_->Erase(page_id);
+        }
+        return page;
+    }
+
+    /**
+     * pick the instance responsible for page_id. Page ids are handed out
+     * sequentially, so a plain modulo spreads them evenly.
+     */
+    BufferPoolManager::BufferPoolInstance &BufferPoolManager::GetInstance(page_id_t page_id) {
+        return instances_[static_cast<size_t>(page_id) % num_instances_];
+    }
+
+    /**
+     * replacer factory, instance.pages_ and instance.pool_size_ must be set
+     */
+    Replacer<Page *> *BufferPoolManager::NewReplacer(BufferPoolInstance &instance) {
+        switch (replacer_type_) {
+            case ReplacerType::CLOCK: {
+                Page *pages = instance.pages_;
+                return new ClockReplacer<Page *>(
+                        instance.pool_size_,
+                        [pages](Page *const &page) { return static_cast<size_t>(page - pages); });
+            }
+            case ReplacerType::LRU_K:
+                return new LRUKReplacer<Page *>(LRUK_REPLACER_K, instance.pool_size_);
+            case ReplacerType::ARC:
+                return new ARCReplacer<Page *>(instance.pool_size_);
+            case ReplacerType::LRU:
+            default:
+                return new LRUReplacer<Page *>;
+        }
+    }
+
     /**
      * try to get one page from free_list_ first. If free_list_ is empty, find a victim page from LRUReplacer.
      * if the victim page is dirty, write the actual data back to disk.
+     * A victim that the background flusher is writing is waited for, which
+     * releases lck for a while; a victim pinned in the meantime is skipped.
+     * caller must hold instance.latch_ through lck
      * @return
      */
-    Page *BufferPoolManager::GetFreeOrUnPinnedPage() {
+    Page *BufferPoolManager::GetFreeOrUnPinnedPage(BufferPoolInstance &instance,
+                                                   unique_lock<TimedMutex> &lck) {
         Page *ans;
-        if (free_list_->empty()) {
-            if (replacer_->Size() == 0) {
+        while (true) {
+            if (!instance.free_list_->empty()) {
+                ans = instance.free_list_->back();
+                instance.free_list_->pop_back();
+                assert(ans->GetPageId() == INVALID_PAGE_ID);
+                assert(!ans->is_dirty_);
+                break;
+            }
+            if (instance.replacer_->Size() == 0) {
                 return nullptr;
-            } else {
-                replacer_->Victim(ans);
-                if (ans->is_dirty_) {
-                    disk_manager_->WritePage(ans->GetPageId(), ans->GetData());
+            }
+            instance.replacer_->Victim(ans);
+            if (ans->is_flushing_) {
+                // the pin keeps DeletePage off the frame, a FetchPage hit
+                // adds its own and the frame is handed back on its unpin
+                ans->pin_count_++;
+                WaitForFlush(instance, ans, lck);
+                if (--ans->pin_count_ > 0) {
+                    continue;
                 }
-
             }
-        } else {
-            ans = free_list_->back();
-            free_list_->pop_back();
-            assert(ans->GetPageId() == INVALID_PAGE_ID);
-            assert(!ans->is_dirty_);
+            instance.evictions_++;
+            if (ans->is_dirty_) {
+                disk_manager_->WritePage(ans->GetPageId(), ans->GetData());
+                foreground_writes_++;
+                instance.dirty_writebacks_++;
+            }
+            // clean by now, the copy matches the disk
+            if (compressed_tier_ != nullptr) {
+                compressed_tier_->Insert(ans->GetPageId(), ans->GetData());
+            }
+            break;
         }
         assert(ans->GetPinCount() == 0);
 
         return ans;
     }
+
+    /**
+     * block until the background write of page is done
+     * caller must hold instance.latch_ through lck
+     */
+    void BufferPoolManager::WaitForFlush(BufferPoolInstance &instance, Page *page,
+                                         unique_lock<TimedMutex> &lck) {
+        if (page->is_flushing_) {
+            instance.pin_waits_++;
+        }
+        instance.flush_cv_.wait(lck, [page] { return !page->is_flushing_; });
+    }
+
+    /**
+     * fill the frame of page_id from the compressed tier, from disk if the
+     * tier does not have the page. The caller holds the frame write latched
+     */
+    void BufferPoolManager::ReadFrame(page_id_t page_id, Page *page) {
+        if (compressed_tier_ != nullptr && compressed_tier_->Take(page_id, page->data_)) {
+            return;
+        }
+        disk_manager_->ReadPage(page_id, page->data_);
+    }
+
+    /**
+     * WAL: a page may only reach disk after every log record up to its LSN
+     */
+    bool BufferPoolManager::IsLogPersisted(Page *page) {
+        if (!ENABLE_LOGGING || log_manager_ == nullptr) {
+            return true;
+        }
+        return page->GetLSN() <= log_manager_->GetPersistentLSN();
+    }
+
+    /**
+     * write back every dirty unpinned frame of instance. Frames are marked
+     * is_flushing_ and cleaned under the latch, the writes happen without it
+     * under the page read latch, so a writer that modifies the page meanwhile
+     * marks it dirty again on unpin. With io the pages whose read latch is
+     * free right away are written together straight from their frames, the
+     * others one by one afterwards. A failed write leaves the page dirty, so
+     * does a page whose LSN moved past the persistent LSN before we got its
+     * read latch
+     */
+    void BufferPoolManager::FlushInstance(BufferPoolInstance &instance, AsyncIO *io) {
+        std::vector<Page *> batch;
+        {
+            lock_guard<TimedMutex> lck(instance.latch_);
+            for (size_t i = 0; i < instance.pool_size_; ++i) {
+                Page *page = &instance.pages_[i];
+                if (page->page_id_ == INVALID_PAGE_ID || !page->is_dirty_ ||
+                    page->pin_count_ > 0 || page->is_flushing_ ||
+                    !IsLogPersisted(page)) {
+                    continue;
+                }
+                page->is_flushing_ = true;
+                page->is_dirty_ = false;
+                batch.push_back(page);
+            }
+        }
+        auto finish = [&](Page *page, bool ok) {
+            page->RUnlatch();
+            background_writes_++;
+            {
+                lock_guard<TimedMutex> lck(instance.latch_);
+                page->is_flushing_ = false;
+                if (!ok) {
+                    page->is_dirty_ = true;
+                }
+            }
+            instance.flush_cv_.notify_all();
+        };
+        // the read latch is held; a writer may have logged past the
+        // persistent LSN since the page was picked
+        auto skip = [&](Page *page) {
+            page->RUnlatch();
+            {
+                lock_guard<TimedMutex> lck(instance.latch_);
+                page->is_flushing_ = false;
+                page->is_dirty_ = true;
+            }
+            instance.flush_cv_.notify_all();
+        };
+        std::vector<Page *> blocked;
+        if (io != nullptr) {
+            std::vector<AsyncIOCompletion> completions;
+            auto reap = [&](size_t min_complete) {
+                completions.clear();
+                io->Reap(completions, min_complete);
+                for (auto &completion : completions) {
+                    finish(reinterpret_cast<Page *>(completion.tag), completion.ok);
+                }
+            };
+            for (Page *page : batch) {
+                // never block on a page latch with writes of ours in flight;
+                // the header page goes through the disk manager, which stamps
+                // the free map into it
+                if (page->GetPageId() == HEADER_PAGE_ID || !page->TryRLatch()) {
+                    blocked.push_back(page);
+                    continue;
+                }
+                if (!IsLogPersisted(page)) {
+                    skip(page);
+                    continue;
+                }
+                while (!io->PrepareWrite(page->GetPageId(), page->GetData(),
+                                         reinterpret_cast<uint64_t>(page))) {
+                    reap(1);
+                }
+            }
+            reap(io->GetInFlight());
+        } else {
+            blocked.swap(batch);
+        }
+        for (Page *page : blocked) {
+            page->RLatch();
+            if (!IsLogPersisted(page)) {
+                skip(page);
+                continue;
+            }
+            disk_manager_->WritePage(page->GetPageId(), page->GetData());
+            finish(page, true);
+        }
+    }
+
+    /**
+     * sum up the counters of every instance. The counters are read one by one
+     * without stopping the pool, so the snapshot is not atomic as a whole
+     */
+    BufferPoolStats BufferPoolManager::GetStats() {
+        BufferPoolStats stats{};
+        for (size_t i = 0; i < num_instances_; ++i) {
+            BufferPoolInstance &instance = instances_[i];
+            stats.hits += instance.hits_;
+            stats.misses += instance.misses_;
+            stats.evictions += instance.evictions_;
+            stats.dirty_writebacks += instance.dirty_writebacks_;
+            stats.pin_waits += instance.pin_waits_;
+            stats.latch_hold_ns += instance.latch_.GetHeldNanos();
+        }
+        stats.foreground_writes = foreground_writes_;
+        stats.background_writes = background_writes_;
+        stats.prefetched_pages = prefetched_pages_;
+        if (compressed_tier_ != nullptr) {
+            stats.tier_hits = compressed_tier_->GetHits();
+            stats.tier_misses = compressed_tier_->GetMisses();
+            stats.tier_bytes = compressed_tier_->GetUsedBytes();
+        }
+        return stats;
+    }
+
+    /**
+     * Start a thread that flushes every instance once per interval
+     */
+    void BufferPoolManager::RunFlushThread(std::chrono::milliseconds interval) {
+        lock_guard<mutex> lck(flush_mutex_);
+        if (flush_running_) {
+            return;
+        }
+        flush_running_ = true;
+        flush_thread_ = new std::thread([this, interval] {
+            AsyncIO *io = disk_manager_->NewAsyncIO(ASYNC_IO_DEPTH);
+            unique_lock<mutex> lck(flush_mutex_);
+            while (flush_running_) {
+                lck.unlock();
+                for (size_t i = 0; i < num_instances_; ++i) {
+                    FlushInstance(instances_[i], io);
+                }
+                lck.lock();
+                flush_cv_.wait_for(lck, interval, [this] { return !flush_running_; });
+            }
+            lck.unlock();
+            delete io;
+        });
+    }
+
+    /**
+     * Stop and join the flush thread
+     */
+    void BufferPoolManager::StopFlushThread() {
+        {
+            lock_guard<mutex> lck(flush_mutex_);
+            if (!flush_running_) {
+                return;
+            }
+            flush_running_ = false;
+        }
+        flush_cv_.notify_all();
+        flush_thread_->join();
+        delete flush_thread_;
+        flush_thread_ = nullptr;
+    }
+
+    /**
+     * queue pages for the prefetch thread, starting it on first use. Pages
+     * that were never allocated are skipped
+     */
+    void BufferPoolManager::PrefetchPages(page_id_t first_page_id, size_t count) {
+        page_id_t end = disk_manager_->GetNextPageId();
+        lock_guard<mutex> lck(prefetch_mutex_);
+        for (size_t i = 0; i < count; ++i) {
+            page_id_t page_id = first_page_id + static_cast<page_id_t>(i);
+            if (page_id < 0 || page_id >= end ||
+                prefetch_queue_.size() >= std::max<size_t>(1, pool_size_ / 2)) {
+                break;
+            }
+            prefetch_queue_.push_back(page_id);
+        }
+        if (!prefetch_running_) {
+            prefetch_running_ = true;
+            prefetch_thread_ = new std::thread([this] {
+                AsyncIO *io = disk_manager_->NewAsyncIO(ASYNC_IO_DEPTH);
+                size_t batch_size = io == nullptr ? 1 : io->GetDepth();
+                std::vector<page_id_t> page_ids;
+                unique_lock<mutex> lck(prefetch_mutex_);
+                while (true) {
+                    prefetch_cv_.wait(lck, [this] {
+                        return !prefetch_running_ || !prefetch_queue_.empty();
+                    });
+                    if (!prefetch_running_) {
+                        break;
+                    }
+                    page_ids.clear();
+                    while (!prefetch_queue_.empty() && page_ids.size() < batch_size) {
+                        page_ids.push_back(prefetch_queue_.front());
+                        prefetch_queue_.pop_front();
+                    }
+                    lck.unlock();
+                    PrefetchBatch(page_ids, io);
+                    lck.lock();
+                }
+                lck.unlock();
+                delete io;
+            });
+        }
+        prefetch_cv_.notify_one();
+    }
+
+    /**
+     * load pages unpinned. Each frame is filled like a FetchPage miss but
+     * counts neither as a miss nor as an access: it enters the replacer
+     * through InsertPrefetched, and the first real fetch is a hit. Resident
+     * pages are left alone. With io the reads of the whole batch are in
+     * flight together. Returns the number of pages read
+     */
+    size_t BufferPoolManager::PrefetchBatch(const std::vector<page_id_t> &page_ids,
+                                            AsyncIO *io) {
+        size_t loaded = 0;
+        std::vector<AsyncIOCompletion> completions;
+        auto reap = [&](size_t min_complete) {
+            completions.clear();
+            io->Reap(completions, min_complete);
+            for (auto &completion : completions) {
+                Page *page = reinterpret_cast<Page *>(completion.tag);
+                if (!completion.ok) {
+                    disk_manager_->ReadPage(completion.page_id, page->data_);
+                }
+                FinishPrefetch(page);
+                loaded++;
+            }
+        };
+        for (page_id_t page_id : page_ids) {
+            Page *page = ClaimPrefetchFrame(page_id);
+            if (page == nullptr) {
+                continue;
+            }
+            if (io == nullptr) {
+                ReadFrame(page_id, page);
+                FinishPrefetch(page);
+                loaded++;
+                continue;
+            }
+            if (compressed_tier_ != nullptr && compressed_tier_->Take(page_id, page->data_)) {
+                FinishPrefetch(page);
+                loaded++;
+                continue;
+            }
+            while (!io->PrepareRead(page_id, page->data_, reinterpret_cast<uint64_t>(page))) {
+                reap(1);
+            }
+        }
+        if (io != nullptr) {
+            reap(io->GetInFlight());
+        }
+        return loaded;
+    }
+
+    /**
+     * take a frame for page_id and publish it as loading, pinned and write
+     * latched, nullptr if the page is resident or no frame is free
+     */
+    Page *BufferPoolManager::ClaimPrefetchFrame(page_id_t page_id) {
+        BufferPoolInstance &instance = GetInstance(page_id);
+        Page *page = nullptr;
+        if (instance.page_table_->Find(page_id, page)) {
+            return nullptr;
+        }
+        unique_lock<TimedMutex> lck(instance.latch_);
+        if (instance.page_table_->Find(page_id, page)) {
+            return nullptr;
+        }
+        page = GetFreeOrUnPinnedPage(instance, lck);
+        if (page == nullptr) {
+            return nullptr;
+        }
+        instance.page_table_->Remove(page->GetPageId());
+        Page *loaded = nullptr;
+        if (instance.page_table_->Find(page_id, loaded)) {
+            // loaded by someone else while we waited for a background write
+            page->page_id_ = INVALID_PAGE_ID;
+            page->is_dirty_ = false;
+            instance.free_list_->push_back(page);
+            return nullptr;
+        }
+        // our pin keeps the frame while it is read, fetchers that find it
+        // wait on the write latch
+        page->page_id_ = page_id;
+        page->is_dirty_ = false;
+        page->is_loading_ = true;
+        page->WLatch();
+        page->pin_count_ = 1;
+        instance.page_table_->Insert(page_id, page);
+        return page;
+    }
+
+    /**
+     * the data of a claimed frame is in, publish it and drop our pin
+     */
+    void BufferPoolManager::FinishPrefetch(Page *page) {
+        BufferPoolInstance &instance = GetInstance(page->page_id_);
+        lock_guard<TimedMutex> lck(instance.latch_);
+        page->is_loading_ = false;
+        page->WUnlatch();
+        if (--page->pin_count_ == 0) {
+            instance.replacer_->InsertPrefetched(page);
+        }
+        prefetched_pages_++;
+    }
+
+    /**
+     * collect (last use, page id) of every resident page instance by instance
+     * and write the ids as raw page_id_t values, most recent first. A page
+     * that is still being read is left out
+     */
+    bool BufferPoolManager::DumpResidentPages(const std::string &file_name) {
+        std::vector<std::pair<uint64_t, page_id_t>> resident;
+        for (size_t i = 0; i < num_instances_; ++i) {
+            BufferPoolInstance &instance = instances_[i];
+            lock_guard<TimedMutex> lck(instance.latch_);
+            for (size_t j = 0; j < instance.pool_size_; ++j) {
+                Page *page = &instance.pages_[j];
+                if (page->page_id_ == INVALID_PAGE_ID || page->is_loading_) {
+                    continue;
+                }
+                uint64_t last_used = page->pin_count_ > 0 ? UINT64_MAX : page->last_used_;
+                resident.emplace_back(last_used, page->page_id_);
+            }
+        }
+        std::sort(resident.begin(), resident.end(),
+                  [](const std::pair<uint64_t, page_id_t> &a,
+                     const std::pair<uint64_t, page_id_t> &b) { return a.first > b.first; });
+        std::vector<page_id_t> page_ids;
+        page_ids.reserve(resident.size());
+        for (auto &entry : resident) {
+            page_ids.push_back(entry.second);
+        }
+        std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char *>(page_ids.data()),
+                  page_ids.size() * sizeof(page_id_t));
+        return out.good();
+    }
+
+    /**
+     * read a dump of DumpResidentPages and start a thread that loads the
+     * first pool_size_ ids, sorted so that the disk is read front to back.
+     * Pages are loaded like prefetches, they count neither as misses nor as
+     * accesses. An earlier warm up is waited for first
+     */
+    bool BufferPoolManager::WarmUp(const std::string &file_name) {
+        std::ifstream in(file_name, std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        std::vector<page_id_t> page_ids(pool_size_);
+        in.read(reinterpret_cast<char *>(page_ids.data()), pool_size_ * sizeof(page_id_t));
+        page_ids.resize(static_cast<size_t>(in.gcount()) / sizeof(page_id_t));
+        page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(),
+                                      [](page_id_t page_id) { return page_id < 0; }),
+                       page_ids.end());
+        std::sort(page_ids.begin(), page_ids.end());
+
+        WaitForWarmUp();
+        {
+            lock_guard<mutex> lck(warm_up_mutex_);
+            warm_up_stats_ = WarmUpStats{0, std::chrono::microseconds(0), false};
+        }
+        warm_up_stop_ = false;
+        warm_up_thread_ = new std::thread([this, page_ids] {
+            auto start = std::chrono::steady_clock::now();
+            AsyncIO *io = disk_manager_->NewAsyncIO(ASYNC_IO_DEPTH);
+            size_t batch_size = io == nullptr ? 1 : io->GetDepth();
+            for (size_t i = 0; i < page_ids.size() && !warm_up_stop_; i += batch_size) {
+                std::vector<page_id_t> batch(
+                        page_ids.begin() + i,
+                        page_ids.begin() + std::min(page_ids.size(), i + batch_size));
+                size_t loaded = PrefetchBatch(batch, io);
+                lock_guard<mutex> lck(warm_up_mutex_);
+                warm_up_stats_.pages_loaded += loaded;
+            }
+            delete io;
+            lock_guard<mutex> lck(warm_up_mutex_);
+            warm_up_stats_.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start);
+            warm_up_stats_.done = true;
+        });
+        return true;
+    }
+
+    /**
+     * join the warm up thread, if any
+     */
+    void BufferPoolManager::WaitForWarmUp() {
+        if (warm_up_thread_ != nullptr) {
+            warm_up_thread_->join();
+            delete warm_up_thread_;
+            warm_up_thread_ = nullptr;
+        }
+    }
+
+    WarmUpStats BufferPoolManager::GetWarmUpStats() {
+        lock_guard<mutex> lck(warm_up_mutex_);
+        return warm_up_stats_;
+    }
+
+    /**
+     * Stop and join the prefetch thread, pending requests are dropped
+     */
+    void BufferPoolManager::StopPrefetchThread() {
+        {
+            lock_guard<mutex> lck(prefetch_mutex_);
+            if (!prefetch_running_) {
+                return;
+            }
+            prefetch_running_ = false;
+            prefetch_queue_.clear();
+        }
+        prefetch_cv_.notify_all();
+        prefetch_thread_->join();
+        delete prefetch_thread_;
+        prefetch_thread_ = nullptr;
+    }
 } // namespace cmudb
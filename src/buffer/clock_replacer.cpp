@@ -0,0 +1,112 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+    template<typename T>
+    ClockReplacer<T>::ClockReplacer(size_t num_frames,
+                                    std::function<size_t(const T &)> frame_id)
+            : frames_(num_frames), evictable_(num_frames, 0),
+              ref_bits_(num_frames, 0), frame_id_(frame_id), hand_(0),
+              size_(0) {}
+
+    template<typename T>
+    ClockReplacer<T>::~ClockReplacer() {}
+
+/*
+ * Make value evictable and give it a second chance
+ */
+    template<typename T>
+    void ClockReplacer<T>::Insert(const T &value) {
+        size_t idx = frame_id_(value);
+        assert(idx < frames_.size());
+        std::lock_guard<std::mutex> lck(latch);
+        if (!evictable_[idx]) {
+            evictable_[idx] = 1;
+            frames_[idx] = value;
+            size_++;
+        }
+        ref_bits_[idx] = 1;
+    }
+
+/*
+ * Make value evictable without a reference bit, a frame that is already
+ * tracked keeps its bit
+ */
+    template<typename T>
+    void ClockReplacer<T>::InsertPrefetched(const T &value) {
+        size_t idx = frame_id_(value);
+        assert(idx < frames_.size());
+        std::lock_guard<std::mutex> lck(latch);
+        if (!evictable_[idx]) {
+            evictable_[idx] = 1;
+            frames_[idx] = value;
+            ref_bits_[idx] = 0;
+            size_++;
+        }
+    }
+
+/* Sweep the clock hand until an evictable slot with a cleared reference bit
+ * is found, clearing bits on the way. Two revolutions are always enough.
+ * If nothing is evictable, return false
+ */
+    template<typename T>
+    bool ClockReplacer<T>::Victim(T &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        if (size_ == 0) {
+            return false;
+        }
+        while (true) {
+            size_t idx = hand_;
+            hand_ = (hand_ + 1) % frames_.size();
+            if (!evictable_[idx]) {
+                continue;
+            }
+            if (ref_bits_[idx]) {
+                ref_bits_[idx] = 0;
+                continue;
+            }
+            evictable_[idx] = 0;
+            size_--;
+            value = frames_[idx];
+            return true;
+        }
+    }
+
+/*
+ * Remove value from replacer. If removal is successful, return true, otherwise
+ * return false
+ */
+    template<typename T>
+    bool ClockReplacer<T>::Erase(const T &value) {
+        size_t idx = frame_id_(value);
+        assert(idx < frames_.size());
+        std::lock_guard<std::mutex> lck(latch);
+        if (!evictable_[idx]) {
+            return false;
+        }
+        evictable_[idx] = 0;
+        ref_bits_[idx] = 0;
+        size_--;
+        return true;
+    }
+
+    template<typename T>
+    size_t ClockReplacer<T>::Size() {
+        std::lock_guard<std::mutex> lck(latch);
+        return size_;
+    }
+
+    template
+    class ClockReplacer<Page *>;
+
+// test only
+    template
+    class ClockReplacer<int>;
+
+} // namespace cmudb
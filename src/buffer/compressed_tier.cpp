@@ -0,0 +1,92 @@
+/**
+ * compressed tier implementation
+ */
+#include "buffer/compressed_tier.h"
+#include "common/lz77.h"
+
+namespace cmudb {
+
+    CompressedTier::CompressedTier(size_t budget, size_t page_size)
+            : budget_(budget), page_size_(page_size), used_(0), hits_(0),
+              misses_(0), evictions_(0) {}
+
+    CompressedTier::~CompressedTier() {}
+
+    /**
+     * compress outside the latch, then replace any older copy and drop the
+     * oldest pages until the new one fits
+     */
+    void CompressedTier::Insert(page_id_t page_id, const char *data) {
+        std::vector<char> compressed;
+        size_t size = LZ77::Compress(data, page_size_, compressed);
+        std::lock_guard<std::mutex> lck(latch_);
+        auto iter = entries_.find(page_id);
+        if (iter != entries_.end()) {
+            Remove(iter);
+        }
+        if (size > page_size_ - page_size_ / 8 || size > budget_) {
+            return;
+        }
+        while (used_ + size > budget_) {
+            Remove(entries_.find(lru_.front()));
+            evictions_++;
+        }
+        Entry &entry = entries_[page_id];
+        entry.data.swap(compressed);
+        entry.pos = lru_.insert(lru_.end(), page_id);
+        used_ += size;
+    }
+
+    /**
+     * the copy is taken out under the latch and decompressed without it
+     */
+    bool CompressedTier::Take(page_id_t page_id, char *data) {
+        std::vector<char> compressed;
+        {
+            std::lock_guard<std::mutex> lck(latch_);
+            auto iter = entries_.find(page_id);
+            if (iter == entries_.end()) {
+                misses_++;
+                return false;
+            }
+            compressed.swap(iter->second.data);
+            used_ -= compressed.size();
+            lru_.erase(iter->second.pos);
+            entries_.erase(iter);
+        }
+        if (!LZ77::Decompress(compressed.data(), compressed.size(), data, page_size_)) {
+            misses_++;
+            return false;
+        }
+        hits_++;
+        return true;
+    }
+
+    void CompressedTier::Erase(page_id_t page_id) {
+        std::lock_guard<std::mutex> lck(latch_);
+        auto iter = entries_.find(page_id);
+        if (iter != entries_.end()) {
+            Remove(iter);
+        }
+    }
+
+    size_t CompressedTier::GetUsedBytes() {
+        std::lock_guard<std::mutex> lck(latch_);
+        return used_;
+    }
+
+    size_t CompressedTier::GetSize() {
+        std::lock_guard<std::mutex> lck(latch_);
+        return entries_.size();
+    }
+
+    /**
+     * caller must hold latch_
+     */
+    void CompressedTier::Remove(std::unordered_map<page_id_t, Entry>::iterator iter) {
+        used_ -= iter->second.data.size();
+        lru_.erase(iter->second.pos);
+        entries_.erase(iter);
+    }
+
+} // namespace cmudb
@@ -0,0 +1,94 @@
+/**
+ * frame_region.cpp
+ */
+#include <cstdint>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "buffer/frame_region.h"
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace cmudb {
+
+    namespace {
+        const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+        // from <numaif.h>, spelled out to avoid depending on libnuma
+        const int MPOL_BIND_MODE = 2;
+
+        inline size_t RoundUp(size_t value, size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    } // namespace
+
+    FrameRegion::FrameRegion(size_t num_frames, size_t frame_size,
+                             bool huge_pages, int numa_node)
+            : frame_size_(frame_size), length_(0), base_(nullptr),
+              huge_pages_(false), numa_bound_(false) {
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        length_ = RoundUp(num_frames == 0 ? 1 : num_frames * frame_size,
+                          huge_pages ? HUGE_PAGE_SIZE : page_size);
+        if (!huge_pages || !MapHugeTLB()) {
+            MapAligned(huge_pages ? HUGE_PAGE_SIZE : page_size);
+            if (huge_pages) {
+                huge_pages_ = madvise(base_, length_, MADV_HUGEPAGE) == 0;
+            }
+        }
+        // the memory is not touched yet, so binding decides where it lands
+        if (numa_node >= 0) {
+            unsigned long node_mask[16] = {0};
+            size_t bits = sizeof(unsigned long) * 8;
+            if (static_cast<size_t>(numa_node) < bits * 16) {
+                node_mask[numa_node / bits] = 1UL << (numa_node % bits);
+                numa_bound_ = syscall(SYS_mbind, base_, length_, MPOL_BIND_MODE,
+                                      node_mask, bits * 16, 0) == 0;
+            }
+            if (!numa_bound_) {
+                LOG_DEBUG("cannot bind frames to numa node %d", numa_node);
+            }
+        }
+    }
+
+    FrameRegion::~FrameRegion() { munmap(base_, length_); }
+
+    /*
+     * explicit huge pages, fails unless the administrator reserved some
+     */
+    bool FrameRegion::MapHugeTLB() {
+        void *addr = mmap(nullptr, length_, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        base_ = static_cast<char *>(addr);
+        huge_pages_ = true;
+        return true;
+    }
+
+    /*
+     * map length_ bytes starting at a multiple of alignment: over-allocate by
+     * one alignment unit and give the unaligned head and the tail back
+     */
+    void FrameRegion::MapAligned(size_t alignment) {
+        size_t mapped = length_ + alignment;
+        void *addr = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE,
+                            "cannot map buffer pool frames");
+        }
+        char *start = static_cast<char *>(addr);
+        char *aligned = reinterpret_cast<char *>(
+                RoundUp(reinterpret_cast<uintptr_t>(start), alignment));
+        if (aligned > start) {
+            munmap(start, aligned - start);
+        }
+        size_t tail = (start + mapped) - (aligned + length_);
+        if (tail > 0) {
+            munmap(aligned + length_, tail);
+        }
+        base_ = aligned;
+    }
+
+} // namespace cmudb
@@ -0,0 +1,183 @@
+/**
+ * LRU-K implementation
+ */
+#include <algorithm>
+#include <cassert>
+
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+    namespace {
+        // PurgeStale is not worth running for fewer cached histories
+        const size_t MIN_PURGE_THRESHOLD = 64;
+
+        // key under which the access history of a value is recorded
+        inline page_id_t HistoryKey(Page *const &page) { return page->GetPageId(); }
+
+        inline page_id_t HistoryKey(const int &value) { return value; }
+    } // namespace
+
+    template<typename T>
+    LRUKReplacer<T>::LRUKReplacer(size_t k, size_t retained_limit)
+            : k_(k == 0 ? 1 : k), retained_limit_(retained_limit),
+              current_timestamp_(0), size_(0),
+              purge_threshold_(MIN_PURGE_THRESHOLD) {}
+
+    template<typename T>
+    LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Record one access of value and make it evictable
+ */
+    template<typename T>
+    void LRUKReplacer<T>::Insert(const T &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        History &history = histories_[HistoryKey(value)];
+        if (history.retained) {
+            retained_.erase(history.retained_pos);
+            history.retained = false;
+        }
+        history.value = value;
+        if (history.prefetched) {
+            history.accesses.clear();
+            history.prefetched = false;
+        }
+        history.accesses.push_back(++current_timestamp_);
+        if (history.accesses.size() > k_) {
+            history.accesses.pop_front();
+        }
+        if (!history.evictable) {
+            history.evictable = true;
+            size_++;
+        }
+        if (histories_.size() - retained_.size() > purge_threshold_) {
+            PurgeStale();
+            purge_threshold_ = std::max(MIN_PURGE_THRESHOLD,
+                                        2 * (histories_.size() - retained_.size()));
+        }
+    }
+
+/*
+ * Make value evictable without recording an access. Victim needs a timestamp
+ * to order values, so a value without history gets a placeholder one
+ */
+    template<typename T>
+    void LRUKReplacer<T>::InsertPrefetched(const T &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        History &history = histories_[HistoryKey(value)];
+        if (history.retained) {
+            retained_.erase(history.retained_pos);
+            history.retained = false;
+        }
+        history.value = value;
+        if (history.accesses.empty()) {
+            history.accesses.push_back(++current_timestamp_);
+            history.prefetched = true;
+        }
+        if (!history.evictable) {
+            history.evictable = true;
+            size_++;
+        }
+    }
+
+/* Pick the evictable value with the largest backward K-distance. Values with
+ * less than K recorded accesses win over everything else, ties are broken by
+ * the oldest recorded access. If nothing is evictable, return false
+ */
+    template<typename T>
+    bool LRUKReplacer<T>::Victim(T &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        if (size_ == 0) {
+            return false;
+        }
+        auto victim = histories_.end();
+        bool victim_infinite = false;
+        for (auto iter = histories_.begin(); iter != histories_.end(); ++iter) {
+            if (!iter->second.evictable) {
+                continue;
+            }
+            bool infinite = iter->second.accesses.size() < k_;
+            // front() is the K-th most recent access, or the first one seen
+            uint64_t timestamp = iter->second.accesses.front();
+            if (victim == histories_.end() ||
+                (infinite && !victim_infinite) ||
+                (infinite == victim_infinite &&
+                 timestamp < victim->second.accesses.front())) {
+                victim = iter;
+                victim_infinite = infinite;
+            }
+        }
+        assert(victim != histories_.end());
+        value = victim->second.value;
+        victim->second.evictable = false;
+        size_--;
+
+        // keep the history of the evicted page around for a while
+        if (retained_limit_ == 0) {
+            histories_.erase(victim);
+            return true;
+        }
+        victim->second.retained = true;
+        victim->second.retained_pos = retained_.insert(retained_.end(), victim->first);
+        if (retained_.size() > retained_limit_) {
+            histories_.erase(retained_.front());
+            retained_.pop_front();
+        }
+        return true;
+    }
+
+/*
+ * Stop tracking value as evictable, its access history is kept. If removal is
+ * successful, return true, otherwise return false
+ */
+    template<typename T>
+    bool LRUKReplacer<T>::Erase(const T &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        auto iter = histories_.find(HistoryKey(value));
+        if (iter == histories_.end() || !iter->second.evictable) {
+            return false;
+        }
+        iter->second.evictable = false;
+        size_--;
+        return true;
+    }
+
+    template<typename T>
+    size_t LRUKReplacer<T>::Size() {
+        std::lock_guard<std::mutex> lck(latch);
+        return size_;
+    }
+
+    template<typename T>
+    size_t LRUKReplacer<T>::GetHistorySize() {
+        std::lock_guard<std::mutex> lck(latch);
+        return histories_.size();
+    }
+
+/*
+ * drop the histories of erased values whose frame no longer holds the page
+ * the history was recorded for. caller must hold latch
+ */
+    template<typename T>
+    void LRUKReplacer<T>::PurgeStale() {
+        for (auto iter = histories_.begin(); iter != histories_.end();) {
+            History &history = iter->second;
+            if (!history.evictable && !history.retained &&
+                HistoryKey(history.value) != iter->first) {
+                iter = histories_.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    template
+    class LRUKReplacer<Page *>;
+
+// test only
+    template
+    class LRUKReplacer<int>;
+
+} // namespace cmudb
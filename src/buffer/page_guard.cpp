@@ -0,0 +1,60 @@
+/**
+ * page_guard.cpp
+ */
+#include "buffer/page_guard.h"
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+
+    PageGuard::PageGuard()
+            : buffer_pool_manager_(nullptr), page_(nullptr), exclusive_(false),
+              is_dirty_(false) {}
+
+    PageGuard::PageGuard(BufferPoolManager *buffer_pool_manager, Page *page,
+                         bool exclusive)
+            : buffer_pool_manager_(buffer_pool_manager), page_(page),
+              exclusive_(exclusive), is_dirty_(false) {
+        if (page_ != nullptr) {
+            page_->Latch(exclusive_);
+        }
+    }
+
+    PageGuard::~PageGuard() { Release(); }
+
+    PageGuard::PageGuard(PageGuard &&other) noexcept
+            : buffer_pool_manager_(other.buffer_pool_manager_),
+              page_(other.page_), exclusive_(other.exclusive_),
+              is_dirty_(other.is_dirty_) {
+        other.page_ = nullptr;
+        other.is_dirty_ = false;
+    }
+
+    PageGuard &PageGuard::operator=(PageGuard &&other) noexcept {
+        if (this != &other) {
+            Release();
+            buffer_pool_manager_ = other.buffer_pool_manager_;
+            page_ = other.page_;
+            exclusive_ = other.exclusive_;
+            is_dirty_ = other.is_dirty_;
+            other.page_ = nullptr;
+            other.is_dirty_ = false;
+        }
+        return *this;
+    }
+
+/*
+ * Unlatch before unpinning: once the pin is gone the frame may be handed to
+ * another page
+ */
+    void PageGuard::Release() {
+        if (page_ == nullptr) {
+            return;
+        }
+        page_id_t page_id = page_->GetPageId();
+        page_->UnLatch(exclusive_);
+        buffer_pool_manager_->UnpinPage(page_id, is_dirty_);
+        page_ = nullptr;
+        is_dirty_ = false;
+    }
+
+} // namespace cmudb
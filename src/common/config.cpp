@@ -4,4 +4,11 @@ namespace cmudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
   std::chrono::duration<long long int> LOG_TIMEOUT =
    std::chrono::seconds(1);
+  std::chrono::milliseconds BACKGROUND_FLUSH_INTERVAL =
+   std::chrono::milliseconds(50);
+  bool BUFFER_POOL_HUGE_PAGES = false;
+  int BUFFER_POOL_NUMA_NODE = -1;
+  size_t BUFFER_POOL_COMPRESSED_TIER_BUDGET = 0;
+  bool DISK_DIRECT_IO = false;
+  size_t ASYNC_IO_DEPTH = 32;
 }
@@ -0,0 +1,160 @@
+/**
+ * lz77.cpp
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "common/lz77.h"
+
+namespace cmudb {
+
+namespace {
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+const int HASH_BITS = 12;
+
+inline uint32_t Read32(const char *p) {
+  uint32_t value;
+  memcpy(&value, p, 4);
+  return value;
+}
+
+inline size_t Hash(uint32_t value) {
+  return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// length bytes after a nibble of 15: 255 means another byte follows
+void WriteLength(std::vector<char> &dst, size_t &pos, size_t length) {
+  while (length >= 255) {
+    dst[pos++] = static_cast<char>(255);
+    length -= 255;
+  }
+  dst[pos++] = static_cast<char>(length);
+}
+
+bool ReadLength(const unsigned char *&ip, const unsigned char *end,
+                size_t &length) {
+  unsigned char byte;
+  do {
+    if (ip == end) {
+      return false;
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+void WriteSequence(std::vector<char> &dst, size_t &pos, const char *literals,
+                   size_t literal_length, size_t offset, size_t match_length) {
+  size_t token_pos = pos++;
+  unsigned char token = 0;
+  if (literal_length >= 15) {
+    token = 15 << 4;
+    WriteLength(dst, pos, literal_length - 15);
+  } else {
+    token = static_cast<unsigned char>(literal_length << 4);
+  }
+  memcpy(dst.data() + pos, literals, literal_length);
+  pos += literal_length;
+  if (match_length > 0) {
+    dst[pos++] = static_cast<char>(offset & 0xff);
+    dst[pos++] = static_cast<char>(offset >> 8);
+    size_t length = match_length - MIN_MATCH;
+    if (length >= 15) {
+      token |= 15;
+      WriteLength(dst, pos, length - 15);
+    } else {
+      token |= static_cast<unsigned char>(length);
+    }
+  }
+  dst[token_pos] = static_cast<char>(token);
+}
+} // namespace
+
+size_t LZ77::MaxCompressedSize(size_t size) { return size + size / 255 + 16; }
+
+size_t LZ77::Compress(const char *src, size_t size, std::vector<char> &dst) {
+  dst.resize(MaxCompressedSize(size));
+  // base + position of the last occurrence of each hashed prefix. The table
+  // is kept per thread; raising base by more than size invalidates every
+  // entry of the previous call without clearing it
+  static thread_local std::vector<uint32_t> table(1 << HASH_BITS, 0);
+  static thread_local uint64_t next_base = 1;
+  if (next_base + size + 1 > UINT32_MAX) {
+    std::fill(table.begin(), table.end(), 0);
+    next_base = 1;
+  }
+  uint32_t base = static_cast<uint32_t>(next_base);
+  next_base += size + 1;
+  size_t pos = 0;
+  size_t anchor = 0;
+  size_t i = 0;
+  while (i + MIN_MATCH <= size) {
+    uint32_t prefix = Read32(src + i);
+    size_t h = Hash(prefix);
+    uint32_t entry = table[h];
+    table[h] = base + static_cast<uint32_t>(i);
+    if (entry < base || i - (entry - base) > MAX_OFFSET ||
+        Read32(src + (entry - base)) != prefix) {
+      i++;
+      continue;
+    }
+    size_t candidate = entry - base;
+    size_t length = MIN_MATCH;
+    while (i + length < size && src[candidate + length] == src[i + length]) {
+      length++;
+    }
+    WriteSequence(dst, pos, src + anchor, i - anchor, i - candidate, length);
+    i += length;
+    anchor = i;
+  }
+  WriteSequence(dst, pos, src + anchor, size - anchor, 0, 0);
+  dst.resize(pos);
+  return pos;
+}
+
+bool LZ77::Decompress(const char *src, size_t size, char *dst,
+                      size_t dst_size) {
+  const unsigned char *ip = reinterpret_cast<const unsigned char *>(src);
+  const unsigned char *end = ip + size;
+  size_t op = 0;
+  while (ip < end) {
+    unsigned char token = *ip++;
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(ip, end, literal_length)) {
+      return false;
+    }
+    if (literal_length > static_cast<size_t>(end - ip) ||
+        literal_length > dst_size - op) {
+      return false;
+    }
+    memcpy(dst + op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    if (ip == end) {
+      break;
+    }
+    if (end - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !ReadLength(ip, end, match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > op || match_length > dst_size - op) {
+      return false;
+    }
+    // byte by byte, a match may overlap the bytes it produces
+    for (size_t k = 0; k < match_length; k++, op++) {
+      dst[op] = dst[op - offset];
+    }
+  }
+  return op == dst_size;
+}
+
+} // namespace cmudb
@@ -0,0 +1,382 @@
+/**
+ * async_io.cpp
+ */
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <linux/io_uring.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "disk/async_io.h"
+
+namespace cmudb {
+
+namespace {
+// pread/pwrite the rest of a page after a short transfer
+bool FinishTransfer(int fd, char *data, size_t size, off_t offset,
+                    bool is_write, size_t done) {
+  while (done < size) {
+    ssize_t count = is_write
+                        ? pwrite(fd, data + done, size - done, offset + done)
+                        : pread(fd, data + done, size - done, offset + done);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0 || (count == 0 && is_write)) {
+      return false;
+    }
+    if (count == 0) {
+      // end of file, the rest of the page reads as zeros
+      memset(data + done, 0, size - done);
+      return true;
+    }
+    done += count;
+  }
+  return true;
+}
+
+/*
+ * io_uring with one submission and one completion ring mapped from the
+ * kernel. Only the owning thread touches the rings, the kernel is the other
+ * side, so the ring indexes are read with acquire and written with release
+ */
+class IoUringAsyncIO : public AsyncIO {
+public:
+  IoUringAsyncIO(int fd, size_t page_size, size_t depth)
+      : AsyncIO(fd, page_size, depth), ring_fd_(-1), sq_ptr_(MAP_FAILED),
+        cq_ptr_(MAP_FAILED), sqes_(static_cast<io_uring_sqe *>(MAP_FAILED)),
+        sq_len_(0), cq_len_(0), sqes_len_(0), to_submit_(0) {}
+
+  ~IoUringAsyncIO() {
+    // the kernel may still write into the pages of requests in flight
+    if (ring_fd_ >= 0 && in_flight_ > 0) {
+      std::vector<AsyncIOCompletion> completions;
+      Reap(completions, in_flight_);
+    }
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_len_);
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_len_);
+    }
+    if (sq_ptr_ != MAP_FAILED) {
+      munmap(sq_ptr_, sq_len_);
+    }
+    if (ring_fd_ >= 0) {
+      close(ring_fd_);
+    }
+  }
+
+  /*
+   * set up and map the rings, false if io_uring is not available
+   */
+  bool Init() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = syscall(__NR_io_uring_setup, depth_, &params);
+    if (ring_fd_ < 0) {
+      LOG_DEBUG("io_uring_setup failed: %s", strerror(errno));
+      return false;
+    }
+    // IORING_OP_READ/WRITE came with 5.6, FAST_POLL with 5.7
+    if (!(params.features & IORING_FEAT_FAST_POLL)) {
+      return false;
+    }
+    sq_len_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_len_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_len_ = cq_len_ = std::max(sq_len_, cq_len_);
+    }
+    sq_ptr_ = mmap(nullptr, sq_len_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ptr_ = single_mmap
+                  ? sq_ptr_
+                  : mmap(nullptr, cq_len_, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring_fd_,
+                         IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_len_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe *>(
+        mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) {
+      return false;
+    }
+    char *sq = static_cast<char *>(sq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    char *cq = static_cast<char *>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    // the ring may be larger than asked for, never run more than depth_
+    requests_.resize(depth_);
+    for (size_t i = 0; i < depth_; i++) {
+      free_slots_.push_back(depth_ - 1 - i);
+    }
+    return true;
+  }
+
+  bool PrepareRead(page_id_t page_id, char *page_data, uint64_t tag) {
+    return Prepare(Request{page_id, page_data, tag, false});
+  }
+
+  bool PrepareWrite(page_id_t page_id, const char *page_data, uint64_t tag) {
+    return Prepare(Request{page_id, const_cast<char *>(page_data), tag, true});
+  }
+
+  void Submit() {
+    while (to_submit_ > 0) {
+      long ret = syscall(__NR_io_uring_enter, ring_fd_, to_submit_, 0, 0,
+                         nullptr, 0);
+      if (ret < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          continue;
+        }
+        LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+        return;
+      }
+      to_submit_ -= ret;
+    }
+  }
+
+  size_t Reap(std::vector<AsyncIOCompletion> &completions,
+              size_t min_complete) {
+    Submit();
+    min_complete = std::min(min_complete, in_flight_);
+    size_t reaped = 0;
+    while (true) {
+      unsigned head = *cq_head_;
+      unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; head++) {
+        io_uring_cqe &cqe = cqes_[head & cq_mask_];
+        size_t slot = cqe.user_data;
+        completions.push_back(Complete(requests_[slot], cqe.res));
+        free_slots_.push_back(slot);
+        in_flight_--;
+        reaped++;
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      if (reaped >= min_complete) {
+        return reaped;
+      }
+      long ret = syscall(__NR_io_uring_enter, ring_fd_, 0,
+                         min_complete - reaped, IORING_ENTER_GETEVENTS,
+                         nullptr, 0);
+      if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+        return reaped;
+      }
+    }
+  }
+
+  inline AsyncIOType GetType() const { return AsyncIOType::IO_URING; }
+
+private:
+  bool Prepare(const Request &request) {
+    if (free_slots_.empty()) {
+      return false;
+    }
+    size_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    requests_[slot] = request;
+
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe &sqe = sqes_[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = request.is_write ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe.fd = fd_;
+    sqe.addr = reinterpret_cast<uint64_t>(request.data);
+    sqe.len = page_size_;
+    sqe.off = static_cast<uint64_t>(request.page_id) * page_size_;
+    sqe.user_data = slot;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    to_submit_++;
+    in_flight_++;
+    return true;
+  }
+
+  int ring_fd_;
+  void *sq_ptr_;
+  void *cq_ptr_;
+  io_uring_sqe *sqes_;
+  size_t sq_len_;
+  size_t cq_len_;
+  size_t sqes_len_;
+  unsigned *sq_tail_;
+  unsigned sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe *cqes_;
+  unsigned to_submit_;
+  std::vector<Request> requests_; // indexed by the user_data of the sqe
+  std::vector<size_t> free_slots_;
+};
+
+/*
+ * worker threads taking submitted requests from a queue and issuing them
+ * with pread/pwrite
+ */
+class ThreadPoolAsyncIO : public AsyncIO {
+public:
+  ThreadPoolAsyncIO(int fd, size_t page_size, size_t depth, size_t num_threads)
+      : AsyncIO(fd, page_size, depth), stop_(false) {
+    for (size_t i = 0; i < num_threads; i++) {
+      workers_.push_back(std::thread([this] { Work(); }));
+    }
+  }
+
+  ~ThreadPoolAsyncIO() {
+    {
+      std::lock_guard<std::mutex> lck(mutex_);
+      stop_ = true;
+    }
+    // workers drain the queue before they exit
+    work_cv_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  bool PrepareRead(page_id_t page_id, char *page_data, uint64_t tag) {
+    return Prepare(Request{page_id, page_data, tag, false});
+  }
+
+  bool PrepareWrite(page_id_t page_id, const char *page_data, uint64_t tag) {
+    return Prepare(Request{page_id, const_cast<char *>(page_data), tag, true});
+  }
+
+  void Submit() {
+    if (prepared_.empty()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lck(mutex_);
+      queue_.insert(queue_.end(), prepared_.begin(), prepared_.end());
+    }
+    prepared_.clear();
+    work_cv_.notify_all();
+  }
+
+  size_t Reap(std::vector<AsyncIOCompletion> &completions,
+              size_t min_complete) {
+    Submit();
+    min_complete = std::min(min_complete, in_flight_);
+    std::unique_lock<std::mutex> lck(mutex_);
+    done_cv_.wait(lck, [&] { return done_.size() >= min_complete; });
+    size_t reaped = done_.size();
+    completions.insert(completions.end(), done_.begin(), done_.end());
+    done_.clear();
+    in_flight_ -= reaped;
+    return reaped;
+  }
+
+  inline AsyncIOType GetType() const { return AsyncIOType::THREAD_POOL; }
+
+private:
+  bool Prepare(const Request &request) {
+    if (in_flight_ >= depth_) {
+      return false;
+    }
+    prepared_.push_back(request);
+    in_flight_++;
+    return true;
+  }
+
+  void Work() {
+    std::unique_lock<std::mutex> lck(mutex_);
+    while (true) {
+      work_cv_.wait(lck, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      Request request = queue_.front();
+      queue_.pop_front();
+      lck.unlock();
+      AsyncIOCompletion completion = Complete(request, 0);
+      lck.lock();
+      done_.push_back(completion);
+      done_cv_.notify_one();
+    }
+  }
+
+  std::vector<Request> prepared_; // only touched by the owning thread
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Request> queue_;           // protected by mutex_
+  std::vector<AsyncIOCompletion> done_; // protected by mutex_
+  bool stop_;                           // protected by mutex_
+};
+
+// pread/pwrite workers of a thread pool backend
+const size_t THREAD_POOL_WORKERS = 4;
+} // namespace
+
+AsyncIO *AsyncIO::Create(int fd, size_t page_size, size_t depth,
+                         AsyncIOType type, std::atomic<uint64_t> *file_size) {
+  if (fd < 0 || depth == 0) {
+    return nullptr;
+  }
+  AsyncIO *io = nullptr;
+  if (type != AsyncIOType::THREAD_POOL) {
+    IoUringAsyncIO *ring = new IoUringAsyncIO(fd, page_size, depth);
+    if (ring->Init()) {
+      io = ring;
+    } else {
+      delete ring;
+      if (type == AsyncIOType::IO_URING) {
+        return nullptr;
+      }
+    }
+  }
+  if (io == nullptr) {
+    io = new ThreadPoolAsyncIO(fd, page_size, depth,
+                               std::min(depth, THREAD_POOL_WORKERS));
+  }
+  io->file_size_ = file_size;
+  return io;
+}
+
+/**
+ * result is what the kernel transferred: bytes or -errno. Whatever is left
+ * of the page is transferred synchronously, a read ending at the end of the
+ * file is padded with zeros
+ */
+AsyncIOCompletion AsyncIO::Complete(const Request &request, long result) {
+  bool ok = false;
+  if (result >= 0) {
+    off_t offset = static_cast<off_t>(request.page_id) * page_size_;
+    ok = FinishTransfer(fd_, request.data, page_size_, offset,
+                        request.is_write, result);
+  }
+  if (!ok) {
+    LOG_DEBUG("I/O error on page %d", request.page_id);
+  } else if (request.is_write && file_size_ != nullptr) {
+    AdvanceFileSize(*file_size_,
+                    (static_cast<uint64_t>(request.page_id) + 1) * page_size_);
+  }
+  return AsyncIOCompletion{request.page_id, request.tag, request.is_write, ok};
+}
+
+} // namespace cmudb
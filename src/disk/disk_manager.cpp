@@ -1,26 +1,98 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <thread>
+#include <unistd.h>
 
+#include "common/exception.h"
 #include "common/logger.h"
 #include "disk/disk_manager.h"
+#include "page/free_map_page.h"
+#include "page/header_page.h"
 
 namespace cmudb {
 
 static char *buffer_used = nullptr;
 
+namespace {
+inline bool IsValidPageSize(size_t page_size) {
+  return page_size >= PAGE_SIZE && page_size <= MAX_PAGE_SIZE &&
+         (page_size & (page_size - 1)) == 0;
+}
+
+// pwrite until all of data is written, false on an I/O error
+bool WriteFully(int fd, const char *data, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, data, size, offset);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+
+// pread until size bytes are read or the file ends, return the bytes read
+// or -1 on an I/O error
+ssize_t ReadFully(int fd, char *data, size_t size, off_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t count = pread(fd, data + done, size - done, offset + done);
+    if (count < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    if (count == 0)
+      break;
+    done += count;
+  }
+  return done;
+}
+
+// heap memory aligned for direct I/O, for callers whose buffers are not
+class AlignedBuffer {
+public:
+  AlignedBuffer(size_t size, size_t alignment) : data_(nullptr) {
+    if (posix_memalign(reinterpret_cast<void **>(&data_), alignment, size) != 0) {
+      throw std::bad_alloc();
+    }
+  }
+  ~AlignedBuffer() { free(data_); }
+  inline char *GetData() const { return data_; }
+
+private:
+  char *data_;
+};
+} // namespace
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
+ * @input page_size: page size of the file if it is created
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
-      flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, size_t page_size)
+    : file_name_(db_file), db_fd_(-1), direct_io_alignment_(0),
+      page_size_(page_size), file_size_(0), next_page_id_(0),
+      free_map_root_(HEADER_PAGE_ID),
+      num_flushes_(0), flush_log_(false), flush_log_f_(nullptr) {
+  if (!IsValidPageSize(page_size_)) {
+    throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE, "invalid page size");
+  }
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -42,62 +114,325 @@ DiskManager::DiskManager(const std::string &db_file)
                                 std::ios::out);
   }
 
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // created if it does not exist yet
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (db_fd_ < 0) {
+    throw Exception(EXCEPTION_TYPE_INVALID, "cannot open database file");
+  }
+
+  // from here on writes keep file_size_ up to date
+  file_size_ = GetFileSize(file_name_);
+  // an existing file keeps the page size its header page recorded
+  if (file_size_ > 0) {
+    ReadHeaderPage();
+  }
+  if (DISK_DIRECT_IO) {
+    EnableDirectIO();
+  }
+  // pages written so far have been allocated, a partial page counts too
+  next_page_id_ = (file_size_ + page_size_ - 1) / page_size_;
+  LoadFreeMap();
+}
+
+/**
+ * follow the chain of free map pages from the header page and collect the
+ * free pages. A page in the chain that is not a free map page, or a range
+ * described twice, ends the chain: the free pages it would have listed are
+ * not reused, nothing else is lost
+ */
+void DiskManager::LoadFreeMap() {
+  if (file_size_ < page_size_) {
+    return;
+  }
+  std::vector<char> page(page_size_);
+  ReadPage(HEADER_PAGE_ID, page.data());
+  if (!HeaderPage::HasMagic(page.data())) {
+    return;
+  }
+  size_t capacity = FreeMapPage::GetCapacity(page_size_);
+  page_id_t page_id = HeaderPage::ReadFreeMapPageId(page.data(), page_size_);
+  page_id_t root = page_id;
+  for (page_id_t count = 0; page_id > HEADER_PAGE_ID &&
+                            page_id < next_page_id_ && count < next_page_id_;
+       count++) {
+    ReadPage(page_id, page.data());
+    size_t index = FreeMapPage::GetIndex(page.data());
+    if (!FreeMapPage::IsFreeMapPage(page.data()) ||
+        index * capacity >= static_cast<size_t>(next_page_id_) ||
+        (index < free_map_page_ids_.size() &&
+         free_map_page_ids_[index] != INVALID_PAGE_ID)) {
+      LOG_DEBUG("free map chain broken at page %d", page_id);
+      if (page_id == root) {
+        root = HEADER_PAGE_ID;
+      }
+      break;
+    }
+    if (index >= free_map_page_ids_.size()) {
+      free_map_page_ids_.resize(index + 1, INVALID_PAGE_ID);
+      free_map_pages_.resize(index + 1);
+    }
+    free_map_page_ids_[index] = page_id;
+    free_map_pages_[index] = page;
+    for (size_t bit = 0; bit < capacity; bit++) {
+      page_id_t free_page_id = static_cast<page_id_t>(index * capacity + bit);
+      if (free_page_id >= next_page_id_) {
+        break;
+      }
+      if (FreeMapPage::IsFree(page.data(), page_size_, free_page_id)) {
+        free_pages_.insert(free_page_id);
+      }
+    }
+    page_id = FreeMapPage::GetNextPageId(page.data());
+  }
+  free_map_root_ = root;
+}
+
+/**
+ * reopen the database file with O_DIRECT once the page size is known. Pages
+ * must be a multiple of the file system block size, which is also taken as
+ * the alignment of offsets and buffers. Falls back to buffered I/O if the
+ * page size does not fit or the file system refuses O_DIRECT
+ */
+void DiskManager::EnableDirectIO() {
+  struct stat st;
+  if (fstat(db_fd_, &st) != 0) {
+    return;
+  }
+  size_t alignment = std::max<size_t>(512, st.st_blksize);
+  if (page_size_ % alignment != 0) {
+    LOG_DEBUG("page size %zu is not a multiple of the block size %zu, no O_DIRECT",
+              page_size_, alignment);
+    return;
+  }
+  int fd = open(file_name_.c_str(), O_RDWR | O_DIRECT | O_CLOEXEC);
+  if (fd < 0) {
+    LOG_DEBUG("cannot open database file with O_DIRECT: %s", strerror(errno));
+    return;
+  }
+  close(db_fd_);
+  db_fd_ = fd;
+  direct_io_alignment_ = alignment;
+}
+
+inline bool DiskManager::IsAligned(const char *page_data) const {
+  return direct_io_alignment_ == 0 ||
+         reinterpret_cast<uintptr_t>(page_data) % direct_io_alignment_ == 0;
+}
+
+/**
+ * take the page size from the header page of an existing file. A legacy
+ * header page is rewritten in the current format, a header page that has not
+ * reached the disk yet (all zero) leaves the requested page size in place.
+ * Throws if the file is not a database file this version can read
+ */
+void DiskManager::ReadHeaderPage() {
+  std::vector<char> header(PAGE_SIZE, 0);
+  if (ReadFully(db_fd_, header.data(), PAGE_SIZE, 0) < 0) {
+    throw Exception(EXCEPTION_TYPE_INVALID, "cannot read header page");
+  }
+  if (HeaderPage::HasMagic(header.data())) {
+    if (HeaderPage::ReadVersion(header.data()) != HeaderPage::VERSION) {
+      throw Exception(EXCEPTION_TYPE_MISMATCH_TYPE,
+                      "unsupported header page version");
+    }
+    size_t recorded = HeaderPage::ReadPageSize(header.data());
+    if (!IsValidPageSize(recorded)) {
+      throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE, "invalid recorded page size");
+    }
+    page_size_ = recorded;
+    return;
+  }
+  if (std::all_of(header.begin(), header.end(), [](char c) { return c == 0; })) {
+    return;
+  }
+  std::vector<char> upgraded(PAGE_SIZE);
+  if (!HeaderPage::UpgradeLegacy(header.data(), upgraded.data())) {
+    throw Exception(EXCEPTION_TYPE_MISMATCH_TYPE,
+                    "not a database file or legacy header page too full");
+  }
+  page_size_ = PAGE_SIZE;
+  if (!WriteFully(db_fd_, upgraded.data(), PAGE_SIZE, 0)) {
+    throw Exception(EXCEPTION_TYPE_INVALID, "cannot upgrade header page");
   }
 }
 
 DiskManager::~DiskManager() {
-  db_io_.close();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
   log_io_.close();
 }
 
 /**
- * Write the contents of the specified page into disk file
+ * Write the contents of the specified page into disk file. pwrite hands the
+ * data to the OS directly, there is no stream buffer to flush and no cursor
+ * shared with other threads. With direct I/O an unaligned page is copied to
+ * an aligned buffer first. The page only reaches the OS cache (the device,
+ * with direct I/O), it is durable once SyncPages returns
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
+  if (page_id == HEADER_PAGE_ID && HeaderPage::HasMagic(page_data)) {
+    WriteHeaderPage(page_data);
+    return;
+  }
+  off_t offset = static_cast<off_t>(page_id) * page_size_;
+  bool ok;
+  if (IsAligned(page_data)) {
+    ok = WriteFully(db_fd_, page_data, page_size_, offset);
+  } else {
+    AlignedBuffer bounce(page_size_, direct_io_alignment_);
+    memcpy(bounce.GetData(), page_data, page_size_);
+    ok = WriteFully(db_fd_, bounce.GetData(), page_size_, offset);
+  }
+  if (!ok) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  AdvanceFileSize(file_size_, offset + page_size_);
+}
+
+/**
+ * the header page goes out with the current first free map page in its
+ * trailer, whatever the caller's copy says
+ */
+void DiskManager::WriteHeaderPage(const char *page_data) {
+  AlignedBuffer header(page_size_, std::max<size_t>(direct_io_alignment_, 64));
+  memcpy(header.GetData(), page_data, page_size_);
+  std::lock_guard<std::mutex> guard(header_latch_);
+  HeaderPage::WriteFreeMapPageId(header.GetData(), page_size_, free_map_root_);
+  if (!WriteFully(db_fd_, header.GetData(), page_size_, 0)) {
+    LOG_DEBUG("I/O error while writing");
+    return;
+  }
+  AdvanceFileSize(file_size_, page_size_);
+}
+
+/**
+ * make root the first free map page and record it in the header page on
+ * disk. Without a header page the free map lasts as long as this object
+ */
+void DiskManager::RecordFreeMapRoot(page_id_t root) {
+  std::lock_guard<std::mutex> guard(header_latch_);
+  free_map_root_ = root;
+  AlignedBuffer header(page_size_, std::max<size_t>(direct_io_alignment_, 64));
+  if (ReadFully(db_fd_, header.GetData(), page_size_, 0) !=
+          static_cast<ssize_t>(page_size_) ||
+      !HeaderPage::HasMagic(header.GetData())) {
+    LOG_DEBUG("no header page, the free map is not persisted");
+    return;
+  }
+  HeaderPage::WriteFreeMapPageId(header.GetData(), page_size_, root);
+  if (!WriteFully(db_fd_, header.GetData(), page_size_, 0)) {
+    LOG_DEBUG("I/O error while writing");
+  }
+}
+
+/**
+ * Write a batch of pages, sorted by page id. Each run of consecutive pages
+ * goes out with a single pwritev, or with direct I/O and unaligned pages
+ * as one write of an aligned copy of the run; a run the kernel only takes
+ * partly is finished page by page
+ */
+void DiskManager::WritePages(
+    const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  std::vector<struct iovec> run;
+  size_t begin = 0;
+  if (!pages.empty() && pages[0].first == HEADER_PAGE_ID &&
+      HeaderPage::HasMagic(pages[0].second)) {
+    WriteHeaderPage(pages[0].second);
+    begin = 1;
+  }
+  while (begin < pages.size()) {
+    size_t end = begin + 1;
+    while (end < pages.size() && end - begin < static_cast<size_t>(IOV_MAX) &&
+           pages[end].first == pages[end - 1].first + 1) {
+      end++;
+    }
+    assert(end == pages.size() || pages[end].first > pages[end - 1].first);
+    run.clear();
+    for (size_t i = begin; i < end; i++) {
+      run.push_back({const_cast<char *>(pages[i].second), page_size_});
+    }
+    off_t offset = static_cast<off_t>(pages[begin].first) * page_size_;
+    bool aligned = std::all_of(
+        pages.begin() + begin, pages.begin() + end,
+        [this](const std::pair<page_id_t, const char *> &page) {
+          return IsAligned(page.second);
+        });
+    bool ok;
+    if (aligned) {
+      ssize_t written = pwritev(db_fd_, run.data(), run.size(), offset);
+      ok = written == static_cast<ssize_t>(run.size() * page_size_);
+    } else {
+      AlignedBuffer bounce(run.size() * page_size_, direct_io_alignment_);
+      for (size_t i = begin; i < end; i++) {
+        memcpy(bounce.GetData() + (i - begin) * page_size_, pages[i].second,
+               page_size_);
+      }
+      ok = WriteFully(db_fd_, bounce.GetData(), run.size() * page_size_,
+                      offset);
+    }
+    if (!ok) {
+      for (size_t i = begin; i < end; i++) {
+        WritePage(pages[i].first, pages[i].second);
+      }
+    } else {
+      AdvanceFileSize(file_size_, offset + run.size() * page_size_);
+    }
+    begin = end;
+  }
+}
+
+AsyncIO *DiskManager::NewAsyncIO(size_t depth, AsyncIOType type) {
+  return AsyncIO::Create(db_fd_, page_size_, depth, type, &file_size_);
+}
+
+/**
+ * fdatasync the database file: one call makes every page written before it
+ * durable, so a checkpoint syncs once after its whole batch
+ */
+bool DiskManager::SyncPages() {
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("cannot sync the database file: %s", strerror(errno));
+    return false;
+  }
+  return true;
 }
 
 /**
- * Read the contents of the specified page into the given memory area
+ * Read the contents of the specified page into the given memory area. The
+ * part of the page past the end of the file reads as zeros. With direct I/O
+ * an unaligned page_data is read through an aligned buffer. The file size is
+ * known in memory, a read costs a single pread
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+  off_t offset = static_cast<off_t>(page_id) * page_size_;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (static_cast<uint64_t>(offset) > file_size_) {
     LOG_DEBUG("I/O error while reading");
     // std::cerr << "I/O error while reading" << std::endl;
+    return;
+  }
+  ssize_t read_count;
+  if (IsAligned(page_data)) {
+    read_count = ReadFully(db_fd_, page_data, page_size_, offset);
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    AlignedBuffer bounce(page_size_, direct_io_alignment_);
+    read_count = ReadFully(db_fd_, bounce.GetData(), page_size_, offset);
+    if (read_count > 0) {
+      memcpy(page_data, bounce.GetData(), read_count);
     }
   }
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    read_count = 0;
+  }
+  // if file ends before reading a whole page
+  if (read_count < static_cast<ssize_t>(page_size_)) {
+    LOG_DEBUG("Read less than a page");
+    // std::cerr << "Read less than a page" << std::endl;
+    memset(page_data + read_count, 0, page_size_ - read_count);
+  }
 }
 
 /**
@@ -158,16 +493,170 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * A free page is reused before the file grows: the one closest to
+ * near_page_id, or the lowest one so that the end of the file frees up
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(page_id_t near_page_id) {
+  std::lock_guard<std::mutex> guard(free_map_latch_);
+  if (free_pages_.empty()) {
+    return next_page_id_++;
+  }
+  auto it = free_pages_.begin();
+  if (near_page_id != INVALID_PAGE_ID) {
+    it = free_pages_.lower_bound(near_page_id);
+    if (it == free_pages_.end() ||
+        (it != free_pages_.begin() &&
+         near_page_id - *std::prev(it) < *it - near_page_id)) {
+      --it;
+    }
+  }
+  page_id_t page_id = *it;
+  free_pages_.erase(it);
+  size_t index = page_id / FreeMapPage::GetCapacity(page_size_);
+  FreeMapPage::SetFree(free_map_pages_[index].data(), page_size_, page_id,
+                       false);
+  WritePage(free_map_page_ids_[index], free_map_pages_[index].data());
+  // the page may reach disk, referenced from others, at any time: after a
+  // crash it must not show up free
+  SyncPages();
+  return page_id;
+}
+
+/**
+ * runs always come from the end of the file
+ */
+page_id_t DiskManager::AllocatePages(size_t count) {
+  std::lock_guard<std::mutex> guard(free_map_latch_);
+  return next_page_id_.fetch_add(static_cast<page_id_t>(count));
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
+ * The pages that pointed to a referenced page may still hold the pointer on
+ * disk, so the page is only queued: the checkpoint frees it once they are
+ * durable (see TakeDeallocatedPages). A page nobody has seen is freed right
+ * away. The header page, free map pages and pages that are free or queued
+ * already are left alone
+ */
+void DiskManager::DeallocatePage(page_id_t page_id, bool referenced) {
+  std::lock_guard<std::mutex> guard(free_map_latch_);
+  if (!IsAllocated(page_id)) {
+    return;
+  }
+  if (referenced) {
+    deallocated_pages_.insert(page_id);
+    return;
+  }
+  FreePage(page_id);
+}
+
+/**
+ * hand the queued pages to a checkpoint that starts now
+ */
+std::vector<page_id_t> DiskManager::TakeDeallocatedPages() {
+  std::lock_guard<std::mutex> guard(free_map_latch_);
+  std::vector<page_id_t> pages(deallocated_pages_.begin(),
+                               deallocated_pages_.end());
+  deallocated_pages_.clear();
+  return pages;
+}
+
+/**
+ * end of the checkpoint that took pages. If durable, every page written
+ * before it started is on disk and the pages are freed, from the last one
+ * so that the file can shrink; otherwise they are queued again
+ */
+void DiskManager::FreeDeallocatedPages(const std::vector<page_id_t> &pages,
+                                       bool durable) {
+  std::lock_guard<std::mutex> guard(free_map_latch_);
+  if (!durable) {
+    deallocated_pages_.insert(pages.begin(), pages.end());
+    return;
+  }
+  if (pages.empty()) {
+    return;
+  }
+  for (auto it = pages.rbegin(); it != pages.rend(); ++it) {
+    if (IsAllocated(*it)) {
+      FreePage(*it);
+    }
+  }
+  SyncPages();
+}
+
+/**
+ * an allocated page that is neither free, queued nor a free map page.
+ * Called with free_map_latch_ held
+ */
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  return page_id > HEADER_PAGE_ID && page_id < next_page_id_ &&
+         free_pages_.count(page_id) == 0 &&
+         deallocated_pages_.count(page_id) == 0 &&
+         std::find(free_map_page_ids_.begin(), free_map_page_ids_.end(),
+                   page_id) == free_map_page_ids_.end();
+}
+
+/**
+ * The page is marked in the free map page of its range. Freeing the last
+ * page of the file truncates the file instead, together with the free pages
+ * right before it. The first page freed in a range without a free map page
+ * becomes that free map page. Called with free_map_latch_ held
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+void DiskManager::FreePage(page_id_t page_id) {
+  size_t capacity = FreeMapPage::GetCapacity(page_size_);
+  if (page_id == next_page_id_ - 1) {
+    TruncateFrom(page_id);
+    return;
+  }
+  size_t index = page_id / capacity;
+  if (index >= free_map_page_ids_.size()) {
+    free_map_page_ids_.resize(index + 1, INVALID_PAGE_ID);
+    free_map_pages_.resize(index + 1);
+  }
+  if (free_map_page_ids_[index] == INVALID_PAGE_ID) {
+    // written before the root points to it
+    std::vector<char> &page = free_map_pages_[index];
+    page.resize(page_size_);
+    FreeMapPage::Format(page.data(), page_size_, index, free_map_root_);
+    free_map_page_ids_[index] = page_id;
+    WritePage(page_id, page.data());
+    RecordFreeMapRoot(page_id);
+    return;
+  }
+  free_pages_.insert(page_id);
+  FreeMapPage::SetFree(free_map_pages_[index].data(), page_size_, page_id,
+                       true);
+  WritePage(free_map_page_ids_[index], free_map_pages_[index].data());
+}
+
+/**
+ * drop page_id, the last page of the file, and the free pages before it
+ * from the file. Called with free_map_latch_ held
+ */
+void DiskManager::TruncateFrom(page_id_t page_id) {
+  size_t capacity = FreeMapPage::GetCapacity(page_size_);
+  std::set<size_t> touched;
+  page_id_t end = page_id;
+  while (end - 1 > HEADER_PAGE_ID && free_pages_.count(end - 1) > 0) {
+    end--;
+    free_pages_.erase(end);
+    size_t index = end / capacity;
+    FreeMapPage::SetFree(free_map_pages_[index].data(), page_size_, end,
+                         false);
+    touched.insert(index);
+  }
+  for (size_t index : touched) {
+    WritePage(free_map_page_ids_[index], free_map_pages_[index].data());
+  }
+  next_page_id_ = end;
+  uint64_t size = static_cast<uint64_t>(end) * page_size_;
+  if (file_size_ > size) {
+    if (ftruncate(db_fd_, size) != 0) {
+      LOG_DEBUG("cannot truncate the database file: %s", strerror(errno));
+      return;
+    }
+    file_size_ = size;
+  }
 }
 
 /**
@@ -183,7 +672,7 @@ bool DiskManager::GetFlushState() const { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+off_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
   return rc == 0 ? stat_buf.st_size : -1;
@@ -1,17 +1,33 @@
+#include <functional>
 #include <list>
+#include <thread>
 
 #include "hash/extendible_hash.h"
 #include "page/page.h"
 
 namespace cmudb {
 
+    namespace {
+        // reader slot of the calling thread, picked once per thread
+        size_t ReaderSlotIndex(size_t num_slots) {
+            static thread_local size_t index =
+                    hash<thread::id>{}(this_thread::get_id());
+            return index % num_slots;
+        }
+    } // namespace
+
 /*
  * constructor
  * array_size: fixed array size for each bucket
  */
     template <typename K, typename V>
-    ExtendibleHash<K, V>::ExtendibleHash(size_t size) {
-        this->bucketSize = size;
+    ExtendibleHash<K, V>::ExtendibleHash(size_t size)
+            : bucketSize(size), bucketNum(1), directory(nullptr), version(0),
+              depthCount(1, 0) {
+        Directory *dir = new Directory(0, 1);
+        dir->slots[0].store(newBucket(0));
+        directories.emplace_back(dir);
+        directory.store(dir);
     }
 
 /*
@@ -29,7 +45,7 @@ namespace cmudb {
     template <typename K, typename V>
     int ExtendibleHash<K, V>::GetGlobalDepth() const {
         lock_guard<mutex> lock(latch);
-        return globalDepth;
+        return directory.load()->globalDepth;
     }
 
 /*
@@ -38,15 +54,14 @@ namespace cmudb {
  */
     template <typename K, typename V>
     int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
-        unique_lock<mutex> globalLock(latch);
-        if (buckets[bucket_id]) {
-            unique_lock<mutex> bucketLock(buckets[bucket_id]->latch);
-            globalLock.unlock();
-            {
-                return buckets[bucket_id]->localDepth;
-            }
+        lock_guard<mutex> globalLock(latch);
+        Directory *dir = directory.load();
+        if (bucket_id < 0 || static_cast<size_t>(bucket_id) >= dir->Size()) {
+            return -1;
         }
-        return -1;
+        Bucket *bucket = dir->slots[bucket_id].load();
+        lock_guard<mutex> bucketLock(bucket->latch);
+        return bucket->localDepth;
     }
 
 /*
@@ -58,18 +73,32 @@ namespace cmudb {
         return bucketNum;
     }
 
+    template <typename K, typename V>
+    size_t ExtendibleHash<K, V>::GetDirectoryCapacity() const {
+        lock_guard<mutex> lock(latch);
+        return directory.load()->capacity;
+    }
+
+/*
+ * number of directories allocated, the current one and those that still wait
+ * for their readers to leave
+ */
+    template <typename K, typename V>
+    size_t ExtendibleHash<K, V>::GetDirectoryCount() const {
+        lock_guard<mutex> lock(latch);
+        return directories.size();
+    }
+
 /*
  * lookup function to find value associate with input key
  */
     template <typename K, typename V>
     bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
-        unique_lock<mutex> globalLock(latch);
-        int pos = getIdx(key);
-        unique_lock<mutex> localLock(buckets[pos]->latch);
-        globalLock.unlock();
-        auto iter = buckets[pos]->mp.find(key);
-        if(iter!=buckets[pos]->mp.end()) {
-            value = iter->second;
+        unique_lock<mutex> localLock;
+        Bucket *cur = lockBucket(key, localLock);
+        int idx = cur->IndexOf(key);
+        if(idx >= 0) {
+            value = cur->values[idx];
             return true;
         } else {
             return false;
@@ -78,22 +107,121 @@ namespace cmudb {
 
 /*
  * delete <key,value> entry in hash table
- * Shrink & Combination is not required for this project
+ * a bucket that drops to half full or empties tries to merge with its buddy
  */
     template <typename K, typename V>
     bool ExtendibleHash<K, V>::Remove(const K &key) {
-        unique_lock<mutex> globalLock(latch);
-        int pos = getIdx(key);
-        unique_lock<mutex> localLock(buckets[pos]->latch);
-        globalLock.unlock();
-        int count = buckets[pos]->mp.erase(key);
-        return count>0;
+        bool merge;
+        {
+            unique_lock<mutex> localLock;
+            Bucket *cur = lockBucket(key, localLock);
+            int idx = cur->IndexOf(key);
+            if(idx < 0) {
+                return false;
+            }
+            // fill the hole with the last slot
+            cur->size--;
+            cur->keys[idx] = cur->keys[cur->size];
+            cur->values[idx] = cur->values[cur->size];
+            merge = cur->localDepth > 0 &&
+                    (cur->size == bucketSize / 2 || cur->size == 0);
+        }
+        if(merge) {
+            coalesce(key);
+        }
+        return true;
     }
 
     template <typename K, typename V>
-    int ExtendibleHash<K, V>::getIdx(const K &key) {
-        return HashKey(key) & ((1u<<(size_t)globalDepth)-1);
+    int ExtendibleHash<K, V>::getIdx(const Directory *dir, const K &key) {
+        return HashKey(key) & (dir->Size() - 1);
     }
+
+/*
+ * lock and return the bucket of key without taking the writer latch. The
+ * directory read is validated against the version once the bucket is locked,
+ * a split or merge that moved in between sends the reader to the writer latch.
+ * The reader slot is held only while the directory is dereferenced, bucket
+ * shells outlive it anyway
+ */
+    template <typename K, typename V>
+    typename ExtendibleHash<K, V>::Bucket *
+    ExtendibleHash<K, V>::lockBucket(const K &key, unique_lock<mutex> &bucketLock) {
+        uint64_t before = version.load(memory_order_acquire);
+        if((before & 1) == 0) {
+            ReaderSlot &slot = readers[ReaderSlotIndex(READER_SLOTS)];
+            // announce before loading the pointer, reclaim checks the other way
+            slot.active.fetch_add(1, memory_order_seq_cst);
+            Directory *dir = directory.load(memory_order_seq_cst);
+            Bucket *cur = dir->slots[getIdx(dir, key)].load(memory_order_acquire);
+            slot.active.fetch_sub(1, memory_order_release);
+            bucketLock = unique_lock<mutex>(cur->latch);
+            if(version.load(memory_order_acquire) == before) {
+                return cur;
+            }
+            bucketLock.unlock();
+        }
+        lock_guard<mutex> globalLock(latch);
+        Directory *dir = directory.load(memory_order_relaxed);
+        Bucket *cur = dir->slots[getIdx(dir, key)].load(memory_order_relaxed);
+        bucketLock = unique_lock<mutex>(cur->latch);
+        return cur;
+    }
+
+/*
+ * make dir the current directory, caller must hold latch
+ */
+    template <typename K, typename V>
+    void ExtendibleHash<K, V>::publish(Directory *dir) {
+        directories.emplace_back(dir);
+        directory.store(dir, memory_order_seq_cst);
+        reclaim();
+    }
+
+/*
+ * free the replaced directories if no reader is between loading a directory
+ * pointer and its last access. A reader that announces itself after the
+ * check loads the current directory, which is never freed here
+ * caller must hold latch
+ */
+    template <typename K, typename V>
+    void ExtendibleHash<K, V>::reclaim() {
+        if(directories.size() <= 1) {
+            return;
+        }
+        for(size_t i=0; i<READER_SLOTS; i++) {
+            if(readers[i].active.load(memory_order_seq_cst) != 0) {
+                return;
+            }
+        }
+        directories.erase(directories.begin(), directories.end() - 1);
+    }
+
+/*
+ * empty bucket of the given local depth, a merged away one is reused first
+ * caller must hold latch
+ */
+    template <typename K, typename V>
+    typename ExtendibleHash<K, V>::Bucket *ExtendibleHash<K, V>::newBucket(int depth) {
+        Bucket *bucket;
+        if(!retiredBuckets.empty()) {
+            bucket = retiredBuckets.back();
+            retiredBuckets.pop_back();
+            bucket->localDepth = depth;
+            bucket->size = 0;
+            bucket->keys.reset(new K[bucketSize]);
+            bucket->values.reset(new V[bucketSize]);
+        } else {
+            bucketStore.emplace_back(new Bucket(depth, bucketSize));
+            bucket = bucketStore.back().get();
+        }
+        if(depthCount.size() <= static_cast<size_t>(depth)) {
+            depthCount.resize(depth + 1, 0);
+        }
+        depthCount[depth]++;
+        return bucket;
+    }
+
 /*
  * insert <key,value> entry in hash table
  * Split & Redistribute bucket when there is overflow and if necessary increase
@@ -101,35 +229,140 @@ namespace cmudb {
  */
     template <typename K, typename V>
     void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
-        unique_lock<mutex> globalLock(latch);
-        shared_ptr<Bucket> cur = buckets[getIdx(key)];
-        while(cur->mp.count(key)==0 && cur->mp.size()>= bucketSize) {
+        lock_guard<mutex> globalLock(latch);
+        Directory *dir = directory.load(memory_order_relaxed);
+        Bucket *cur = dir->slots[getIdx(dir, key)].load(memory_order_relaxed);
+        unique_lock<mutex> localLock(cur->latch);
+        while(cur->IndexOf(key) < 0 && cur->size >= bucketSize) {
+            // readers that locked cur before this point have a valid view,
+            // the ones that read the directory from now on have to retry
+            version.fetch_add(1, memory_order_acq_rel);
             auto mask = 1u<<(unsigned)(cur->localDepth);
+            depthCount[cur->localDepth]--;
             cur->localDepth++;
+            int globalDepth = dir->globalDepth.load(memory_order_relaxed);
             if(cur->localDepth > globalDepth) {
-                globalDepth++;
-                int length = buckets.size();
-                for(int i=0; i<length; i++) {
-                    buckets.push_back(buckets[i]);
+                size_t length = dir->Size();
+                if(2 * length > dir->capacity) {
+                    Directory *next = new Directory(globalDepth, 2 * length);
+                    for(size_t i=0; i<length; i++) {
+                        next->slots[i].store(dir->slots[i].load(memory_order_relaxed),
+                                             memory_order_relaxed);
+                    }
+                    publish(next);
+                    dir = next;
+                }
+                for(size_t i=0; i<length; i++) {
+                    dir->slots[i + length].store(dir->slots[i].load(memory_order_relaxed),
+                                                 memory_order_release);
                 }
+                dir->globalDepth.store(globalDepth + 1, memory_order_release);
             }
             bucketNum++;
-            auto newBucketPtr = make_shared<Bucket>(cur->localDepth);
-            for(auto iter =cur->mp.begin(); iter!=cur->mp.end();) {
-                if(HashKey(iter->first) & mask) {
-                    newBucketPtr->mp[iter->first] = iter->second;
+            Bucket *newBucketPtr = newBucket(cur->localDepth);
+            depthCount[cur->localDepth]++;
+            size_t kept = 0;
+            for(size_t i=0; i<cur->size; i++) {
+                if(HashKey(cur->keys[i]) & mask) {
+                    newBucketPtr->keys[newBucketPtr->size] = cur->keys[i];
+                    newBucketPtr->values[newBucketPtr->size] = cur->values[i];
+                    newBucketPtr->size++;
                 } else {
-                    iter++;
+                    cur->keys[kept] = cur->keys[i];
+                    cur->values[kept] = cur->values[i];
+                    kept++;
+                }
+            }
+            cur->size = kept;
+            for(size_t i=0; i<dir->Size(); i++) {
+                if(dir->slots[i].load(memory_order_relaxed) == cur && (i & mask)) {
+                    dir->slots[i].store(newBucketPtr, memory_order_release);
                 }
             }
-            for(size_t i=0; i<buckets.size(); i++) {
-                if(buckets[i]== cur && (i & mask)) {
-                    buckets[i] = newBucketPtr;
+            version.fetch_add(1, memory_order_release);
+            Bucket *target = dir->slots[getIdx(dir, key)].load(memory_order_relaxed);
+            if(target != cur) {
+                localLock = unique_lock<mutex>(target->latch);
+                cur = target;
+            }
+        }
+        int idx = cur->IndexOf(key);
+        if(idx < 0) {
+            idx = cur->size++;
+            cur->keys[idx] = key;
+        }
+        cur->values[idx] = value;
+    }
+
+/*
+ * merge the bucket of key with its buddy as long as both share the local
+ * depth and their entries fit into one bucket, then halve the directory while
+ * no bucket uses its top bit. The upper half of a halved directory is left
+ * as it was, it is rewritten before the depth grows again. Once the live
+ * part is down to a quarter of the capacity, it moves into a directory half
+ * as large, which still leaves room for one split round before a regrow
+ */
+    template <typename K, typename V>
+    void ExtendibleHash<K, V>::coalesce(const K &key) {
+        lock_guard<mutex> globalLock(latch);
+        Directory *dir = directory.load(memory_order_relaxed);
+        while(true) {
+            Bucket *cur = dir->slots[getIdx(dir, key)].load(memory_order_relaxed);
+            int depth = cur->localDepth;
+            if(depth == 0) {
+                break;
+            }
+            size_t low = getIdx(dir, key) & ((1u << (unsigned)(depth - 1)) - 1);
+            size_t high = low | (1u << (unsigned)(depth - 1));
+            Bucket *lowBucket = dir->slots[low].load(memory_order_relaxed);
+            Bucket *highBucket = dir->slots[high].load(memory_order_relaxed);
+            // readers hold at most one bucket latch, so taking two is safe
+            unique_lock<mutex> lowLock(lowBucket->latch);
+            unique_lock<mutex> highLock(highBucket->latch);
+            if(highBucket->localDepth != depth || lowBucket->localDepth != depth ||
+               lowBucket->size + highBucket->size > bucketSize) {
+                break;
+            }
+
+            version.fetch_add(1, memory_order_acq_rel);
+            for(size_t i=0; i<highBucket->size; i++) {
+                lowBucket->keys[lowBucket->size] = highBucket->keys[i];
+                lowBucket->values[lowBucket->size] = highBucket->values[i];
+                lowBucket->size++;
+            }
+            depthCount[depth] -= 2;
+            depthCount[depth - 1]++;
+            lowBucket->localDepth = depth - 1;
+            for(size_t i=0; i<dir->Size(); i++) {
+                if(dir->slots[i].load(memory_order_relaxed) == highBucket) {
+                    dir->slots[i].store(lowBucket, memory_order_release);
+                }
+            }
+            // a late reader may still lock the shell, but it fails validation
+            // before it looks at the slot arrays
+            highBucket->size = 0;
+            highBucket->keys.reset();
+            highBucket->values.reset();
+            retiredBuckets.push_back(highBucket);
+            bucketNum--;
+            int globalDepth = dir->globalDepth.load(memory_order_relaxed);
+            while(globalDepth > 0 && depthCount[globalDepth] == 0) {
+                globalDepth--;
+            }
+            dir->globalDepth.store(globalDepth, memory_order_release);
+            size_t length = dir->Size();
+            if(4 * length <= dir->capacity) {
+                Directory *next = new Directory(globalDepth, 2 * length);
+                for(size_t i=0; i<length; i++) {
+                    next->slots[i].store(dir->slots[i].load(memory_order_relaxed),
+                                         memory_order_relaxed);
                 }
+                publish(next);
+                dir = next;
             }
-            cur = buckets[getIdx(key)];
+            version.fetch_add(1, memory_order_release);
         }
-        cur->mp[key] = value;
+        reclaim();
     }
 
     template class ExtendibleHash<page_id_t, Page *>;
@@ -0,0 +1,177 @@
+#include <functional>
+
+#include "common/exception.h"
+#include "hash/lock_free_hash_table.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+/*
+ * constructor
+ * size: maximum number of entries, the slot array holds at least twice as many
+ */
+    template<typename K, typename V>
+    LockFreeHashTable<K, V>::LockFreeHashTable(size_t size)
+            : capacity_(2), shift_(63), size_(0), version_(0) {
+        while (capacity_ < 2 * size) {
+            capacity_ <<= 1;
+            shift_--;
+        }
+        slots_ = new Slot[capacity_];
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].used.store(false, std::memory_order_relaxed);
+            slots_[i].key.store(K(), std::memory_order_relaxed);
+            slots_[i].value.store(V(), std::memory_order_relaxed);
+        }
+    }
+
+    template<typename K, typename V>
+    LockFreeHashTable<K, V>::~LockFreeHashTable() {
+        delete[] slots_;
+    }
+
+/*
+ * helper function to pick the first slot to probe for key: fibonacci hashing
+ * keeps sequential page ids apart
+ */
+    template<typename K, typename V>
+    size_t LockFreeHashTable<K, V>::HomeSlot(const K &key) const {
+        uint64_t hash = static_cast<uint64_t>(std::hash<K>{}(key));
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+
+    template<typename K, typename V>
+    void LockFreeHashTable<K, V>::BeginWrite() {
+        version_.store(version_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    template<typename K, typename V>
+    void LockFreeHashTable<K, V>::EndWrite() {
+        version_.store(version_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+    }
+
+/*
+ * lookup function to find value associate with input key. The probe is
+ * retried whenever a writer was active while it ran
+ */
+    template<typename K, typename V>
+    bool LockFreeHashTable<K, V>::Find(const K &key, V &value) {
+        size_t mask = capacity_ - 1;
+        size_t home = HomeSlot(key);
+        while (true) {
+            uint64_t version = version_.load(std::memory_order_acquire);
+            if (version & 1) {
+                continue;
+            }
+            bool found = false;
+            V result = V();
+            size_t idx = home;
+            for (size_t n = 0; n < capacity_; ++n) {
+                Slot &slot = slots_[idx];
+                if (!slot.used.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                if (slot.key.load(std::memory_order_relaxed) == key) {
+                    result = slot.value.load(std::memory_order_relaxed);
+                    found = true;
+                    break;
+                }
+                idx = (idx + 1) & mask;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version_.load(std::memory_order_relaxed) == version) {
+                if (found) {
+                    value = result;
+                }
+                return found;
+            }
+        }
+    }
+
+/*
+ * delete <key,value> entry in hash table. Entries behind it in the same probe
+ * run are shifted back so that no tombstone is needed
+ */
+    template<typename K, typename V>
+    bool LockFreeHashTable<K, V>::Remove(const K &key) {
+        std::lock_guard<std::mutex> lck(latch);
+        size_t mask = capacity_ - 1;
+        size_t hole = HomeSlot(key);
+        while (true) {
+            if (!slots_[hole].used.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            if (slots_[hole].key.load(std::memory_order_relaxed) == key) {
+                break;
+            }
+            hole = (hole + 1) & mask;
+        }
+
+        BeginWrite();
+        size_t idx = hole;
+        while (true) {
+            idx = (idx + 1) & mask;
+            Slot &slot = slots_[idx];
+            if (!slot.used.load(std::memory_order_relaxed)) {
+                break;
+            }
+            K moved_key = slot.key.load(std::memory_order_relaxed);
+            size_t home = HomeSlot(moved_key);
+            // the entry stays if its home lies cyclically in (hole, idx]
+            bool stays = hole <= idx ? (hole < home && home <= idx)
+                                     : (hole < home || home <= idx);
+            if (stays) {
+                continue;
+            }
+            slots_[hole].key.store(moved_key, std::memory_order_relaxed);
+            slots_[hole].value.store(slot.value.load(std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+            hole = idx;
+        }
+        slots_[hole].used.store(false, std::memory_order_relaxed);
+        size_--;
+        EndWrite();
+        return true;
+    }
+
+/*
+ * insert <key,value> entry in hash table, an existing value of key is
+ * overwritten. Throws if the table is full
+ */
+    template<typename K, typename V>
+    void LockFreeHashTable<K, V>::Insert(const K &key, const V &value) {
+        std::lock_guard<std::mutex> lck(latch);
+        size_t mask = capacity_ - 1;
+        size_t idx = HomeSlot(key);
+        while (slots_[idx].used.load(std::memory_order_relaxed) &&
+               !(slots_[idx].key.load(std::memory_order_relaxed) == key)) {
+            idx = (idx + 1) & mask;
+        }
+        bool exists = slots_[idx].used.load(std::memory_order_relaxed);
+        // always keep one slot empty so that every probe terminates
+        if (!exists && size_ + 1 >= capacity_) {
+            throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE, "page table is full");
+        }
+        BeginWrite();
+        slots_[idx].key.store(key, std::memory_order_relaxed);
+        slots_[idx].value.store(value, std::memory_order_relaxed);
+        slots_[idx].used.store(true, std::memory_order_relaxed);
+        EndWrite();
+        if (!exists) {
+            size_++;
+        }
+    }
+
+    template<typename K, typename V>
+    size_t LockFreeHashTable<K, V>::GetSize() {
+        std::lock_guard<std::mutex> lck(latch);
+        return size_;
+    }
+
+    template class LockFreeHashTable<page_id_t, Page *>;
+// test purpose
+    template class LockFreeHashTable<int, int>;
+} // namespace cmudb
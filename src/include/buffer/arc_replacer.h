@@ -0,0 +1,75 @@
+/**
+ * arc_replacer.h
+ *
+ * Functionality: Adaptive Replacement Cache. Cached pages live in two lists,
+ * T1 (seen once recently) and T2 (seen at least twice). Evicted pages leave a
+ * ghost entry, keyed by page id, in B1 or B2 respectively. A miss that hits a
+ * ghost in B1 means T1 was too small and grows the target size p of T1, a hit
+ * in B2 shrinks it, so the pool keeps tuning itself between recency (scans)
+ * and frequency (index lookups). Victim evicts from T1 while it is larger than
+ * p and from T2 otherwise, skipping pinned pages.
+ *
+ * Insert counts as one access of the value, Erase pins it in place.
+ * InsertPrefetched puts a value into T1 without counting an access, so its
+ * first real access leaves it in T1 instead of promoting it to T2. A ghost
+ * that is prefetched loses its ghost hit.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace cmudb {
+
+    template<typename T>
+    class ARCReplacer : public Replacer<T> {
+    public:
+        // capacity: number of frames the replacer is caching for
+        explicit ARCReplacer(size_t capacity);
+
+        ~ARCReplacer();
+
+        void Insert(const T &value);
+
+        void InsertPrefetched(const T &value);
+
+        bool Victim(T &value);
+
+        bool Erase(const T &value);
+
+        size_t Size();
+
+        // current target size of T1, exposed for tests
+        size_t GetTarget();
+
+    private:
+        enum ListId { T1 = 0, T2, B1, B2, NUM_LISTS };
+
+        struct Entry {
+            ListId list;
+            std::list<page_id_t>::iterator pos;
+            T value = T(); // valid for T1/T2 only
+            bool evictable = false;
+            bool prefetched = false; // in T1 without a real access yet
+        };
+
+        void MoveTo(page_id_t key, Entry &entry, ListId list);
+        void Drop(ListId list);
+        void Trim();
+        void PurgeStale();
+
+        size_t capacity_;
+        size_t target_; // p, target size of T1
+        size_t size_;   // number of evictable values
+        size_t evictable_[2]; // evictable values in T1 and T2
+        std::list<page_id_t> lists_[NUM_LISTS]; // LRU at front, MRU at back
+        std::unordered_map<page_id_t, Entry> entries_;
+        std::mutex latch;
+    };
+
+} // namespace cmudb
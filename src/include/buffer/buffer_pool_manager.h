@@ -4,24 +4,126 @@
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
  * it, also to unpin a page in the buffer pool.
+ *
+ * The pool can be partitioned into several independent instances. Each
+ * instance owns a slice of the frames together with its own page table,
+ * replacer, free list and latch, and a page is always served by the instance
+ * selected by its page id, so operations on different instances never contend.
+ *
+ * Pin counts are atomic: fetching a page that is resident and pinned by
+ * someone else, and unpinning a page that stays pinned, take no latch at all,
+ * so hot pages such as a B+ tree root do not serialize on the instance.
+ *
+ * A FetchPage miss reads the page with the instance latch released; the frame
+ * is published as loading and its write latch is held until the data is in,
+ * so only fetchers of that very page wait for the read.
+ *
+ * PrefetchPages hands page ids to a prefetch thread (spawned on first use)
+ * that loads them into the pool without pinning them, so a sequential scan
+ * finds the next pages resident. A prefetch is neither a miss nor an access
+ * for the replacer, the first fetch of the page counts as its first use.
+ * The prefetch, warm up and flush threads each keep up to ASYNC_IO_DEPTH
+ * page I/Os in flight through their own AsyncIO.
+ *
+ * NewPage takes its page id from the disk manager before it latches the
+ * instance that id maps to, and maps the page under that latch. NewPages
+ * allocates a run of ids with one call and latches each instance once for all
+ * the pages of the run it serves; it either creates the whole run or nothing.
+ *
+ * FetchPageRead, FetchPageWrite and NewPageGuarded hand out RAII guards (see
+ * page_guard.h) that latch the page and unpin it once when they go away.
+ *
+ * FlushAllPages is the checkpoint: it copies every dirty frame under the page
+ * read latch, so the caller must not hold a page write latch, sorts the pages
+ * by id, writes them as one batch and syncs the file once at the end.
+ *
+ * Frame data is kept apart from the Page bookkeeping in one aligned region
+ * (see FrameRegion), optionally on huge pages and bound to a NUMA node as set
+ * by BUFFER_POOL_HUGE_PAGES and BUFFER_POOL_NUMA_NODE.
+ *
+ * Every instance keeps counters of its hits, misses, evictions and waits and
+ * the time its latch is held; GetStats sums them up for the whole pool.
+ *
+ * With BUFFER_POOL_COMPRESSED_TIER_BUDGET set, evicted pages are kept
+ * compressed in memory (see CompressedTier) and a miss that finds its page
+ * there does not read the disk.
+ *
+ * DumpResidentPages writes the ids of the resident pages, most recently used
+ * first, and WarmUp loads such a dump in the background after a restart, as
+ * many of the most recent pages as fit and in page id order, so the pool does
+ * not start cold.
+ *
+ * An optional background flusher writes dirty unpinned frames back ahead of
+ * time so that evictions usually find clean victims and do not write while
+ * holding the instance latch.
  */
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_tier.h"
+#include "buffer/frame_region.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_guard.h"
+#include "common/timed_mutex.h"
 #include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
+#include "hash/lock_free_hash_table.h"
 #include "logging/log_manager.h"
+#include "page/header_page.h"
 #include "page/page.h"
 
 namespace cmudb {
+    // replacement policy used by every instance of the pool
+    enum class ReplacerType { LRU = 0, CLOCK, LRU_K, ARC };
+
+    // snapshot of the counters of a pool
+    struct BufferPoolStats {
+        uint64_t hits;              // FetchPage found the page resident
+        uint64_t misses;            // FetchPage read the page into a frame
+        uint64_t evictions;         // frames taken over from another page
+        uint64_t dirty_writebacks;  // dirty victims written while evicting
+        uint64_t foreground_writes; // see GetForegroundWriteCount
+        uint64_t background_writes;
+        uint64_t prefetched_pages;
+        uint64_t pin_waits;         // waits for a frame being read or written
+        uint64_t latch_hold_ns;     // time the instance latches were held
+        uint64_t tier_hits;         // misses served by the compressed tier
+        uint64_t tier_misses;       // misses the compressed tier could not serve
+        uint64_t tier_bytes;        // compressed bytes held by the tier
+    };
+
+    // progress of a WarmUp, elapsed is final once done is set
+    struct WarmUpStats {
+        size_t pages_loaded;
+        std::chrono::microseconds elapsed;
+        bool done;
+    };
+
+    // outcome of a FlushAllPages call
+    struct FlushStats {
+        size_t pages_flushed;
+        std::chrono::microseconds elapsed;
+        bool synced; // false if the pages may not be durable
+    };
+
     class BufferPoolManager {
     public:
         BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                          LogManager *log_manager = nullptr);
+                          LogManager *log_manager = nullptr,
+                          size_t num_instances = 1,
+                          ReplacerType replacer_type = ReplacerType::LRU);
 
         ~BufferPoolManager();
 
@@ -29,21 +131,148 @@ namespace cmudb {
 
         bool UnpinPage(page_id_t page_id, bool is_dirty);
 
+        // write the page without syncing it, see FlushAllPages
         bool FlushPage(page_id_t page_id);
 
-        Page *NewPage(page_id_t &page_id);
+        // checkpoint: write back every dirty page as one sorted batch
+        FlushStats FlushAllPages();
+
+        Page *NewPage(page_id_t &page_id, page_id_t near_page_id = INVALID_PAGE_ID);
+
+        // create count consecutive pages at once, pinned, for bulk loads
+        bool NewPages(size_t count, page_id_t &first_page_id, std::vector<Page *> &pages);
 
         bool DeletePage(page_id_t page_id);
 
+        // FetchPage/NewPage returning a latched page that unpins itself
+        ReadPageGuard FetchPageRead(page_id_t page_id);
+
+        WritePageGuard FetchPageWrite(page_id_t page_id);
+
+        WritePageGuard NewPageGuarded(page_id_t &page_id,
+                                      page_id_t near_page_id = INVALID_PAGE_ID);
+
+        inline size_t GetPoolSize() const { return pool_size_; }
+
+        // page size of the database file, the size of every frame
+        inline size_t GetPageSize() const { return page_size_; }
+
+        inline size_t GetNumInstances() const { return num_instances_; }
+
+        inline ReplacerType GetReplacerType() const { return replacer_type_; }
+
+        inline const FrameRegion &GetFrameRegion() const { return *frame_region_; }
+
+        // nullptr without a compressed tier
+        inline CompressedTier *GetCompressedTier() const { return compressed_tier_; }
+
+        // load pages [first_page_id, first_page_id + count) into the pool in
+        // the background, requests beyond half the pool size are dropped
+        void PrefetchPages(page_id_t first_page_id, size_t count);
+
+        // number of pages a sequential TableIterator prefetches, 0 disables
+        inline void SetReadAheadWindow(size_t window) { read_ahead_window_ = window; }
+
+        inline size_t GetReadAheadWindow() const { return read_ahead_window_; }
+
+        // pages actually read by the prefetch thread
+        inline uint64_t GetPrefetchCount() const { return prefetched_pages_; }
+
+        // write the ids of the resident pages to file_name, most recently
+        // used first; pinned pages count as in use right now
+        bool DumpResidentPages(const std::string &file_name);
+
+        // load the pages of a dump in the background, false if there is none
+        bool WarmUp(const std::string &file_name);
+
+        void WaitForWarmUp();
+
+        WarmUpStats GetWarmUpStats();
+
+        // spawn a thread that writes dirty unpinned frames back periodically
+        void RunFlushThread(std::chrono::milliseconds interval = BACKGROUND_FLUSH_INTERVAL);
+        void StopFlushThread();
+
+        // pages written while serving a request (eviction, FlushPage) and by
+        // the background flusher
+        inline uint64_t GetForegroundWriteCount() const { return foreground_writes_; }
+
+        inline uint64_t GetBackgroundWriteCount() const { return background_writes_; }
+
+        BufferPoolStats GetStats();
+
     private:
-        size_t pool_size_; // number of pages in buffer pool
-        Page *pages_;      // array of pages
+        // one independent partition of the buffer pool
+        struct BufferPoolInstance {
+            size_t pool_size_;                         // number of pages in this instance
+            Page *pages_;                              // array of pages
+            HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
+            Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
+            std::list<Page *> *free_list_; // to find a free page for replacement
+            TimedMutex latch_;             // to protect this instance
+            std::condition_variable_any flush_cv_; // a background write finished
+            // statistics
+            std::atomic<uint64_t> hits_{0};
+            std::atomic<uint64_t> misses_{0};
+            std::atomic<uint64_t> evictions_{0};
+            std::atomic<uint64_t> dirty_writebacks_{0};
+            std::atomic<uint64_t> pin_waits_{0};
+        };
+
+        size_t pool_size_;     // number of pages in buffer pool
+        size_t page_size_;     // taken from the disk manager
+        size_t num_instances_; // number of partitions
+        ReplacerType replacer_type_;
+        BufferPoolInstance *instances_;
+        FrameRegion *frame_region_; // data of all frames, instance by instance
+        CompressedTier *compressed_tier_; // evicted pages, nullptr if disabled
         DiskManager *disk_manager_;
         LogManager *log_manager_;
-        HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
-        Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
-        std::list<Page *> *free_list_; // to find a free page for replacement
-        std::mutex latch_;             // to protect shared data structure
-        Page *GetFreeOrUnPinnedPage();
+
+        // background flusher
+        std::thread *flush_thread_;
+        bool flush_running_; // protected by flush_mutex_
+        std::mutex flush_mutex_;
+        std::condition_variable flush_cv_;
+        std::atomic<uint64_t> foreground_writes_;
+        std::atomic<uint64_t> background_writes_;
+
+        // prefetch
+        std::thread *prefetch_thread_;
+        bool prefetch_running_; // protected by prefetch_mutex_
+        std::deque<page_id_t> prefetch_queue_; // protected by prefetch_mutex_
+        std::mutex prefetch_mutex_;
+        std::condition_variable prefetch_cv_;
+        std::atomic<size_t> read_ahead_window_;
+        std::atomic<uint64_t> prefetched_pages_;
+
+        // recency of the unpins, see DumpResidentPages
+        std::atomic<uint64_t> access_clock_;
+
+        // warm up
+        std::thread *warm_up_thread_;
+        std::atomic<bool> warm_up_stop_;
+        std::mutex warm_up_mutex_;
+        WarmUpStats warm_up_stats_; // protected by warm_up_mutex_
+
+        BufferPoolInstance &GetInstance(page_id_t page_id);
+        Replacer<Page *> *NewReplacer(BufferPoolInstance &instance);
+        Page *GetFreeOrUnPinnedPage(BufferPoolInstance &instance,
+                                    std::unique_lock<TimedMutex> &lck);
+        Page *InstallNewPage(BufferPoolInstance &instance, page_id_t page_id,
+                             std::unique_lock<TimedMutex> &lck);
+        bool DropPage(page_id_t page_id, bool referenced);
+        bool TryPinFast(BufferPoolInstance &instance, Page *page, page_id_t page_id);
+        Page *PinResident(BufferPoolInstance &instance, Page *page,
+                          std::unique_lock<TimedMutex> &lck);
+        void WaitForFlush(BufferPoolInstance &instance, Page *page,
+                          std::unique_lock<TimedMutex> &lck);
+        bool IsLogPersisted(Page *page);
+        void FlushInstance(BufferPoolInstance &instance, AsyncIO *io);
+        void ReadFrame(page_id_t page_id, Page *page);
+        size_t PrefetchBatch(const std::vector<page_id_t> &page_ids, AsyncIO *io);
+        Page *ClaimPrefetchFrame(page_id_t page_id);
+        void FinishPrefetch(Page *page);
+        void StopPrefetchThread();
     };
 } // namespace cmudb
@@ -0,0 +1,51 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK (second chance) approximation of LRU. Every frame owns
+ * a slot in fixed size arrays holding an "evictable" flag and a reference bit.
+ * Insert/Erase only flip flags of one slot, so the hit path never allocates or
+ * relinks list nodes. Victim sweeps a clock hand over the slots, clearing
+ * reference bits until it finds an evictable frame whose bit is already clear.
+ * A prefetched frame starts without its reference bit.
+ */
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+    template<typename T>
+    class ClockReplacer : public Replacer<T> {
+    public:
+        // num_frames: number of slots, frame_id: maps a value to its slot
+        ClockReplacer(size_t num_frames,
+                      std::function<size_t(const T &)> frame_id);
+
+        ~ClockReplacer();
+
+        void Insert(const T &value);
+
+        void InsertPrefetched(const T &value);
+
+        bool Victim(T &value);
+
+        bool Erase(const T &value);
+
+        size_t Size();
+
+    private:
+        std::vector<T> frames_;          // value currently held by each slot
+        std::vector<char> evictable_;    // slot is tracked by the replacer
+        std::vector<char> ref_bits_;     // slot was referenced since last sweep
+        std::function<size_t(const T &)> frame_id_;
+        size_t hand_;
+        size_t size_;
+        mutable std::mutex latch;
+    };
+
+} // namespace cmudb
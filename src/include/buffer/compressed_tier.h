@@ -0,0 +1,74 @@
+/**
+ * compressed_tier.h
+ *
+ * Functionality: optional second tier of the buffer pool. Clean pages leaving
+ * the pool are kept LZ77 compressed in memory (see common/lz77.h) up to a
+ * byte budget, and a FetchPage miss looks here before it reads the disk.
+ * The tier is exclusive: a page leaves it when it is read back into a frame,
+ * so the pool and the tier never both hold a page and a copy cannot go
+ * stale. Over budget, the least recently stored pages are dropped. Pages that
+ * shrink by less than an eighth are not worth the decompression and are not
+ * stored.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+    class CompressedTier {
+    public:
+        // budget: bytes of compressed data kept at most
+        CompressedTier(size_t budget, size_t page_size);
+
+        ~CompressedTier();
+
+        // store a copy of a clean page that leaves the pool
+        void Insert(page_id_t page_id, const char *data);
+
+        // move page_id out of the tier into data, false on a tier miss
+        bool Take(page_id_t page_id, char *data);
+
+        // forget page_id, its copy must not outlive a delete or a reuse
+        void Erase(page_id_t page_id);
+
+        inline size_t GetBudget() const { return budget_; }
+
+        size_t GetUsedBytes();
+
+        size_t GetSize();
+
+        inline uint64_t GetHits() const { return hits_; }
+
+        inline uint64_t GetMisses() const { return misses_; }
+
+        // pages dropped to stay within the budget
+        inline uint64_t GetEvictions() const { return evictions_; }
+
+    private:
+        struct Entry {
+            std::vector<char> data;
+            std::list<page_id_t>::iterator pos;
+        };
+
+        void Remove(std::unordered_map<page_id_t, Entry>::iterator iter);
+
+        size_t budget_;
+        size_t page_size_;
+        size_t used_; // compressed bytes held
+        std::unordered_map<page_id_t, Entry> entries_;
+        std::list<page_id_t> lru_; // oldest first
+        std::mutex latch_;
+        std::atomic<uint64_t> hits_;
+        std::atomic<uint64_t> misses_;
+        std::atomic<uint64_t> evictions_;
+    };
+
+} // namespace cmudb
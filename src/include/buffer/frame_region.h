@@ -0,0 +1,52 @@
+/**
+ * frame_region.h
+ *
+ * Functionality: backing memory of the buffer pool frames. The data of all
+ * frames lives in one anonymous mapping, apart from the Page bookkeeping, so
+ * every frame is aligned for direct I/O and a large pool can be served by
+ * 2MB pages. With huge pages requested the region is first mapped from the
+ * hugetlb pool and, when none is reserved, aligned to 2MB and advised for
+ * transparent huge pages. The region can also be bound to one NUMA node.
+ * Both requests are best effort, the region falls back to normal pages of any
+ * node and reports what it actually got.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace cmudb {
+
+    class FrameRegion {
+    public:
+        // numa_node < 0 leaves placement to the kernel
+        FrameRegion(size_t num_frames, size_t frame_size, bool huge_pages,
+                    int numa_node);
+
+        ~FrameRegion();
+
+        FrameRegion(const FrameRegion &) = delete;
+
+        FrameRegion &operator=(const FrameRegion &) = delete;
+
+        inline char *GetFrame(size_t index) const { return base_ + index * frame_size_; }
+
+        inline size_t GetLength() const { return length_; }
+
+        // mapped from hugetlbfs or advised for transparent huge pages
+        inline bool IsHugePageBacked() const { return huge_pages_; }
+
+        inline bool IsNumaBound() const { return numa_bound_; }
+
+    private:
+        bool MapHugeTLB();
+        void MapAligned(size_t alignment);
+
+        size_t frame_size_;
+        size_t length_;
+        char *base_;
+        bool huge_pages_;
+        bool numa_bound_;
+    };
+
+} // namespace cmudb
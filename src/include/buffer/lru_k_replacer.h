@@ -0,0 +1,82 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement. Every Insert counts as one access of the
+ * value and the replacer remembers the timestamps of the last K accesses. The
+ * victim is the evictable value with the largest backward K-distance, i.e. the
+ * one whose K-th most recent access is the oldest. Values accessed fewer than
+ * K times have an infinite distance and are evicted first (oldest first), so
+ * pages touched once by a sequential scan never push out pages that are
+ * referenced repeatedly, like B+ tree internal pages.
+ *
+ * History is keyed by page id (the value itself for the integer test
+ * instantiation). It survives Erase, and the history of evicted pages is
+ * retained for the last `retained_limit` victims, so a page that keeps coming
+ * back is recognized as hot even if it was evicted in between.
+ *
+ * DeletePage only erases the value of a deleted page, so its frame may since
+ * hold another page or none. The history of such values is dropped by a purge
+ * that runs whenever the number of cached histories has doubled since the
+ * last one, which keeps the table proportional to the pool.
+ *
+ * InsertPrefetched records no access. A page without history gets a
+ * placeholder timestamp that only orders it among the pages seen once, and
+ * is dropped again by its first real access.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace cmudb {
+
+    template<typename T>
+    class LRUKReplacer : public Replacer<T> {
+    public:
+        LRUKReplacer(size_t k, size_t retained_limit);
+
+        ~LRUKReplacer();
+
+        void Insert(const T &value);
+
+        void InsertPrefetched(const T &value);
+
+        bool Victim(T &value);
+
+        bool Erase(const T &value);
+
+        size_t Size();
+
+        // number of pages with a recorded access history
+        size_t GetHistorySize();
+
+    private:
+        struct History {
+            std::deque<uint64_t> accesses; // at most k_ timestamps, oldest first
+            T value = T();                 // valid while the page is cached
+            bool evictable = false;
+            bool retained = false;         // page was evicted, only history left
+            bool prefetched = false;       // accesses holds a placeholder only
+            std::list<page_id_t>::iterator retained_pos;
+        };
+
+        size_t k_;
+        size_t retained_limit_;
+        uint64_t current_timestamp_;
+        size_t size_; // number of evictable values
+        size_t purge_threshold_; // cached histories that trigger PurgeStale
+        std::unordered_map<page_id_t, History> histories_;
+        std::list<page_id_t> retained_; // evicted pages, oldest first
+        mutable std::mutex latch;
+
+        void PurgeStale();
+    };
+
+} // namespace cmudb
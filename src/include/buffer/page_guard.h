@@ -0,0 +1,86 @@
+/**
+ * page_guard.h
+ *
+ * Functionality: RAII handles on a pinned and latched buffer pool page. A
+ * guard is obtained from BufferPoolManager::FetchPageRead, FetchPageWrite or
+ * NewPageGuarded, which pin the page once and latch it in the guard's mode.
+ * The guard carries the Page together with that latch mode and a dirty flag,
+ * and on Release or destruction unlatches the page and unpins it exactly
+ * once. Guards can be moved, e.g. into a crabbing path, but not copied; an
+ * empty guard (default constructed, moved from or released) owns nothing.
+ */
+
+#pragma once
+
+#include "page/page.h"
+
+namespace cmudb {
+
+    class BufferPoolManager;
+
+    class PageGuard {
+    public:
+        PageGuard();
+
+        ~PageGuard();
+
+        PageGuard(PageGuard &&other) noexcept;
+
+        PageGuard &operator=(PageGuard &&other) noexcept;
+
+        PageGuard(const PageGuard &) = delete;
+
+        PageGuard &operator=(const PageGuard &) = delete;
+
+        // false if the pool could not provide the page
+        inline bool IsValid() const { return page_ != nullptr; }
+
+        inline Page *GetPage() const { return page_; }
+
+        inline page_id_t GetPageId() const { return page_->GetPageId(); }
+
+        inline char *GetData() const { return page_->GetData(); }
+
+        // the page content viewed as T, e.g. a b+ tree or table page
+        template<typename T>
+        inline T *As() const { return reinterpret_cast<T *>(page_->GetData()); }
+
+        inline bool IsExclusive() const { return exclusive_; }
+
+        inline bool IsDirty() const { return is_dirty_; }
+
+        // unlatch and unpin now, the guard becomes empty
+        void Release();
+
+    protected:
+        // page is pinned by the caller, the guard latches it
+        PageGuard(BufferPoolManager *buffer_pool_manager, Page *page,
+                  bool exclusive);
+
+        BufferPoolManager *buffer_pool_manager_;
+        Page *page_;
+        bool exclusive_;
+        bool is_dirty_;
+    };
+
+    // shared latch, never dirties the page
+    class ReadPageGuard : public PageGuard {
+    public:
+        ReadPageGuard() = default;
+
+        ReadPageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+                : PageGuard(buffer_pool_manager, page, false) {}
+    };
+
+    // exclusive latch, the page is unpinned dirty once MarkDirty was called
+    class WritePageGuard : public PageGuard {
+    public:
+        WritePageGuard() = default;
+
+        WritePageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+                : PageGuard(buffer_pool_manager, page, true) {}
+
+        inline void MarkDirty() { is_dirty_ = true; }
+    };
+
+} // namespace cmudb
@@ -14,6 +14,9 @@ public:
   Replacer() {}
   virtual ~Replacer() {}
   virtual void Insert(const T &value) = 0;
+  // make value evictable without counting an access, for pages that were
+  // read ahead of use; replacers without access history just Insert it
+  virtual void InsertPrefetched(const T &value) { Insert(value); }
   virtual bool Victim(T &value) = 0;
   virtual bool Erase(const T &value) = 0;
   virtual size_t Size() = 0;
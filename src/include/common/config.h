@@ -8,6 +8,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 
 namespace cmudb {
@@ -16,15 +17,36 @@ extern std::chrono::duration<long long int> LOG_TIMEOUT;
 
 extern std::atomic<bool> ENABLE_LOGGING;
 
+extern std::chrono::milliseconds BACKGROUND_FLUSH_INTERVAL;
+
+// frame memory of buffer pools created afterwards: back it with 2MB pages,
+// bind it to a NUMA node (-1: no binding)
+extern bool BUFFER_POOL_HUGE_PAGES;
+extern int BUFFER_POOL_NUMA_NODE;
+
+// bytes of compressed evicted pages kept by buffer pools created afterwards,
+// 0: no compressed tier
+extern size_t BUFFER_POOL_COMPRESSED_TIER_BUDGET;
+
+// open the database file of disk managers created afterwards with O_DIRECT,
+// used if the page size is a multiple of the file system block size
+extern bool DISK_DIRECT_IO;
+
+// page I/Os the prefetch and flush threads of a buffer pool keep in flight
+// (see AsyncIO), 0: they read and write one page at a time
+extern size_t ASYNC_IO_DEPTH;
+
 #define INVALID_PAGE_ID -1 // representing an invalid page id
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
 #define HEADER_PAGE_ID 0   // the header page id
-#define PAGE_SIZE 512     // size of a data page in byte
-#define LOG_BUFFER_SIZE                                                            \
-  ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
+#define PAGE_SIZE 512     // page size of new database files in byte
+#define MAX_PAGE_SIZE 65536 // largest page size a database file may use
+#define LOG_BUFFER_PAGES (BUFFER_POOL_SIZE + 1) // size of a log buffer in pages
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
 #define BUFFER_POOL_SIZE 10            // size of buffer pool
+#define LRUK_REPLACER_K 2              // history depth of LRU-K replacer
+#define READ_AHEAD_WINDOW 8            // pages prefetched ahead of a seq scan
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
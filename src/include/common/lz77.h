@@ -0,0 +1,33 @@
+/**
+ * lz77.h
+ *
+ * Small LZ77 block codec in the spirit of LZ4, for page sized buffers. A
+ * block is a series of sequences: a token byte (literal length in the high
+ * nibble, match length - 4 in the low nibble, 15 meaning more length bytes
+ * follow), the literals, then a two byte little endian offset back into the
+ * output. The last sequence has literals only. Matches are found greedily
+ * through a hash table of 4 byte prefixes, which is cheap enough to run
+ * while evicting a frame and does well on the zero padding of B+ tree and
+ * table pages.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace cmudb {
+class LZ77 {
+public:
+  // worst case size of a compressed block of size bytes
+  static size_t MaxCompressedSize(size_t size);
+
+  // compress size bytes of src into dst (resized to fit), return its size
+  static size_t Compress(const char *src, size_t size, std::vector<char> &dst);
+
+  // decompress a block, false if it is corrupt or does not inflate to
+  // exactly dst_size bytes
+  static bool Decompress(const char *src, size_t size, char *dst,
+                         size_t dst_size);
+};
+} // namespace cmudb
@@ -0,0 +1,97 @@
+/**
+ * timed_mutex.h
+ *
+ * Mutex that accumulates the time it is held, for latch instrumentation.
+ * Satisfies Lockable, use it with std::unique_lock and
+ * std::condition_variable_any.
+ *
+ * Hold times are taken from the time stamp counter on x86, a clock read
+ * through clock_gettime can cost more than the critical section it measures.
+ * Ticks are converted to nanoseconds only when the total is read.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace cmudb {
+class TimedMutex {
+
+  typedef std::mutex mutex_t;
+  typedef std::chrono::steady_clock clock_t;
+
+public:
+  TimedMutex() : acquired_(0), held_ticks_(0) {}
+
+  TimedMutex(const TimedMutex &) = delete;
+  TimedMutex &operator=(const TimedMutex &) = delete;
+
+  void lock() {
+    mutex_.lock();
+    acquired_ = Ticks();
+  }
+
+  bool try_lock() {
+    if (!mutex_.try_lock())
+      return false;
+    acquired_ = Ticks();
+    return true;
+  }
+
+  void unlock() {
+    uint64_t held = Ticks() - acquired_;
+    // only the holder writes, no read-modify-write needed
+    held_ticks_.store(held_ticks_.load(std::memory_order_relaxed) + held,
+                      std::memory_order_relaxed);
+    mutex_.unlock();
+  }
+
+  // total time the mutex has been held, in nanoseconds
+  uint64_t GetHeldNanos() const {
+    return static_cast<uint64_t>(
+        held_ticks_.load(std::memory_order_relaxed) * NanosPerTick());
+  }
+
+private:
+  static inline uint64_t Ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               clock_t::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  // calibrated once against the steady clock
+  static double NanosPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const double nanos_per_tick = [] {
+      auto start = clock_t::now();
+      uint64_t start_ticks = Ticks();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      uint64_t ticks = Ticks() - start_ticks;
+      auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       clock_t::now() - start)
+                       .count();
+      return ticks == 0 ? 1.0 : static_cast<double>(nanos) / ticks;
+    }();
+    return nanos_per_tick;
+#else
+    return 1.0;
+#endif
+  }
+
+  mutex_t mutex_;
+  uint64_t acquired_; // protected by mutex_
+  std::atomic<uint64_t> held_ticks_;
+};
+} // namespace cmudb
@@ -10,9 +10,9 @@
 #include <thread>
 #include <unordered_set>
 
+#include "buffer/page_guard.h"
 #include "common/config.h"
 #include "common/logger.h"
-#include "page/page.h"
 #include "table/tuple.h"
 
 namespace cmudb {
@@ -56,7 +56,7 @@ public:
         exclusive_lock_set_{new std::unordered_set<RID>} {
     // initialize sets
     write_set_.reset(new std::deque<WriteRecord>);
-    page_set_.reset(new std::deque<Page *>);
+    page_set_.reset(new std::deque<WritePageGuard>);
     deleted_page_set_.reset(new std::unordered_set<page_id_t>);
   }
 
@@ -73,9 +73,13 @@ public:
     return write_set_;
   }
 
-  inline std::shared_ptr<std::deque<Page *>> GetPageSet() { return page_set_; }
+  inline std::shared_ptr<std::deque<WritePageGuard>> GetPageSet() {
+    return page_set_;
+  }
 
-  inline void AddIntoPageSet(Page *page) { page_set_->push_back(page); }
+  inline void AddIntoPageSet(WritePageGuard &&guard) {
+    page_set_->push_back(std::move(guard));
+  }
 
   inline std::shared_ptr<std::unordered_set<page_id_t>> GetDeletedPageSet() {
     return deleted_page_set_;
@@ -113,8 +117,8 @@ private:
   lsn_t prev_lsn_;
 
   // Below are used by concurrent index
-  // this deque contains page pointer that was latche during index operation
-  std::shared_ptr<std::deque<Page *>> page_set_;
+  // this deque contains the guards of the pages latched during index operation
+  std::shared_ptr<std::deque<WritePageGuard>> page_set_;
   // this set contains page_id that was deleted during index operation
   std::shared_ptr<std::unordered_set<page_id_t>> deleted_page_set_;
 
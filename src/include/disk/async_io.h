@@ -0,0 +1,96 @@
+/**
+ * async_io.h
+ *
+ * Asynchronous page I/O on the database file. Reads and writes are prepared
+ * one by one, handed over together with Submit and their completions are
+ * collected in batches with Reap, so a caller keeps many page I/Os in flight
+ * from a single thread.
+ *
+ * Two backends implement it: io_uring, driven with raw syscalls so that no
+ * liburing is needed, and a small thread pool issuing pread/pwrite for
+ * kernels or sandboxes without io_uring. Create picks io_uring when it can.
+ *
+ * An AsyncIO is used by one thread at a time; every thread that does
+ * asynchronous I/O gets its own from DiskManager::NewAsyncIO. The backends
+ * live in async_io.cpp and are only reachable through Create. A read that
+ * reaches past the end of the file fills the rest of the page with zeros, a
+ * short transfer is finished synchronously before it completes.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+enum class AsyncIOType { AUTO = 0, IO_URING, THREAD_POOL };
+
+// raise a file size kept in memory to cover a write that ended at end
+inline void AdvanceFileSize(std::atomic<uint64_t> &file_size, uint64_t end) {
+  uint64_t size = file_size.load();
+  while (size < end && !file_size.compare_exchange_weak(size, end)) {
+  }
+}
+
+struct AsyncIOCompletion {
+  page_id_t page_id;
+  uint64_t tag; // passed to PrepareRead/PrepareWrite
+  bool is_write;
+  bool ok; // false on an I/O error
+};
+
+class AsyncIO {
+public:
+  // nullptr if the requested backend is not available, AUTO falls back to
+  // the thread pool. file_size, if given, is advanced by completed writes
+  static AsyncIO *Create(int fd, size_t page_size, size_t depth,
+                         AsyncIOType type = AsyncIOType::AUTO,
+                         std::atomic<uint64_t> *file_size = nullptr);
+
+  AsyncIO(int fd, size_t page_size, size_t depth)
+      : fd_(fd), page_size_(page_size), depth_(depth), in_flight_(0),
+        file_size_(nullptr) {}
+  virtual ~AsyncIO() {}
+
+  // queue one page, false if depth requests are prepared or in flight
+  virtual bool PrepareRead(page_id_t page_id, char *page_data,
+                           uint64_t tag) = 0;
+  virtual bool PrepareWrite(page_id_t page_id, const char *page_data,
+                            uint64_t tag) = 0;
+  // start the prepared requests
+  virtual void Submit() = 0;
+  // append finished requests to completions, waiting until at least
+  // min_complete of them (at most the number in flight) are there. Submits
+  // prepared requests first. Returns the number appended
+  virtual size_t Reap(std::vector<AsyncIOCompletion> &completions,
+                      size_t min_complete) = 0;
+
+  virtual AsyncIOType GetType() const = 0;
+
+  // prepared or submitted and not reaped yet
+  inline size_t GetInFlight() const { return in_flight_; }
+
+  inline size_t GetDepth() const { return depth_; }
+
+protected:
+  struct Request {
+    page_id_t page_id;
+    char *data;
+    uint64_t tag;
+    bool is_write;
+  };
+
+  // finish a request the kernel transferred result bytes of
+  AsyncIOCompletion Complete(const Request &request, long result);
+
+  int fd_;
+  size_t page_size_;
+  size_t depth_;
+  size_t in_flight_;
+  std::atomic<uint64_t> *file_size_;
+};
+
+} // namespace cmudb
@@ -5,31 +5,101 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * Pages are read and written with pread/pwrite on one file descriptor. There
+ * is no shared file cursor, so concurrent page I/O takes no latch. NewAsyncIO
+ * gives a thread its own queue of asynchronous page I/Os on the same file.
+ *
+ * With DISK_DIRECT_IO set the file is opened with O_DIRECT, so pages are not
+ * cached by the OS a second time next to the buffer pool. Buffers handed to
+ * ReadPage, WritePage and WritePages may have any alignment, unaligned ones
+ * are copied through an aligned buffer; buffers handed to an AsyncIO must be
+ * aligned to GetDirectIOAlignment(), as buffer pool frames are.
+ *
+ * The page size is fixed per database file. A new file uses the size passed
+ * to the constructor, an existing one keeps the size recorded in its header
+ * page (see header_page.h). A legacy file is upgraded in place and uses the
+ * compile-time PAGE_SIZE; a file that is neither is refused with an
+ * Exception.
+ *
+ * Deallocated pages are recorded in free map pages (see free_map_page.h) and
+ * handed out again by AllocatePage before the file grows; freeing the last
+ * page truncates the file. The header page records the first free map page,
+ * freeing a page and every write of the header page keep it up to date, so
+ * the free map survives a restart only in a file that has a header page.
+ *
+ * There is no log of page deallocation, so the free map has to stay crash
+ * consistent with the pages on disk by ordering alone. A deallocated page is
+ * only freed by the next checkpoint (BufferPoolManager::FlushAllPages) once
+ * the pages that dropped their pointer to it are synced, and a reused page is
+ * synced as allocated before AllocatePage returns it. A crash loses at most
+ * free pages, never hands out a live one.
  */
 
 #pragma once
 #include <atomic>
 #include <fstream>
 #include <future>
+#include <mutex>
+#include <set>
 #include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "disk/async_io.h"
 
 namespace cmudb {
 
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  // page_size: power of two in [PAGE_SIZE, MAX_PAGE_SIZE], used for new files
+  DiskManager(const std::string &db_file, size_t page_size = PAGE_SIZE);
   ~DiskManager();
 
+  // not durable until the next SyncPages
   void WritePage(page_id_t page_id, const char *page_data);
   void ReadPage(page_id_t page_id, char *page_data);
+  // write many pages at once, pages sorted by ascending page id
+  void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages);
+  // make every page written so far durable, false if the file cannot be
+  // synced
+  bool SyncPages();
+  // asynchronous page I/O keeping up to depth pages in flight, owned by the
+  // caller; nullptr if depth is 0 or there is no database file
+  AsyncIO *NewAsyncIO(size_t depth, AsyncIOType type = AsyncIOType::AUTO);
 
   void WriteLog(char *log_data, int size);
   bool ReadLog(char *log_data, int size, int offset);
 
-  page_id_t AllocatePage();
-  void DeallocatePage(page_id_t page_id);
+  // near_page_id: reuse the free page closest to it, the lowest if invalid
+  page_id_t AllocatePage(page_id_t near_page_id = INVALID_PAGE_ID);
+  // allocate count consecutive pages, return the first page id
+  page_id_t AllocatePages(size_t count);
+  // referenced: other pages may point to it, see TakeDeallocatedPages
+  void DeallocatePage(page_id_t page_id, bool referenced = true);
+  // a checkpoint takes the pages deallocated so far when it starts and frees
+  // them when it ends, if every page written before it is durable then
+  std::vector<page_id_t> TakeDeallocatedPages();
+  void FreeDeallocatedPages(const std::vector<page_id_t> &pages, bool durable);
+
+  // pages below this id have been handed out by AllocatePage
+  inline page_id_t GetNextPageId() const { return next_page_id_; }
+
+  // pages below GetNextPageId that are free to be reused
+  inline size_t GetFreePageCount() {
+    std::lock_guard<std::mutex> guard(free_map_latch_);
+    return free_pages_.size();
+  }
+
+  inline size_t GetPageSize() const { return page_size_; }
+
+  // size of the database file, tracked in memory as pages are written
+  inline uint64_t GetDbFileSize() const { return file_size_; }
+
+  // alignment of offsets and buffers with O_DIRECT, 0 for buffered I/O
+  inline size_t GetDirectIOAlignment() const { return direct_io_alignment_; }
 
   int GetNumFlushes() const;
   bool GetFlushState() const;
@@ -37,14 +107,37 @@ public:
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
 private:
-  int GetFileSize(const std::string &name);
+  off_t GetFileSize(const std::string &name);
+  void ReadHeaderPage();
+  void EnableDirectIO();
+  void LoadFreeMap();
+  void WriteHeaderPage(const char *page_data);
+  void RecordFreeMapRoot(page_id_t root);
+  bool IsAllocated(page_id_t page_id);
+  void FreePage(page_id_t page_id);
+  void TruncateFrom(page_id_t page_id);
+  bool IsAligned(const char *page_data) const;
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
   std::string file_name_;
+  // db file, only accessed with pread/pwrite
+  int db_fd_;
+  size_t direct_io_alignment_;
+  size_t page_size_;
+  // stat()ed once at open, advanced by every write that extends the file
+  std::atomic<uint64_t> file_size_;
   std::atomic<page_id_t> next_page_id_;
+  // free space, see free_map_page.h; protected by free_map_latch_
+  std::mutex free_map_latch_;
+  std::vector<page_id_t> free_map_page_ids_; // by range, or INVALID_PAGE_ID
+  std::vector<std::vector<char>> free_map_pages_;
+  std::set<page_id_t> free_pages_;
+  std::set<page_id_t> deallocated_pages_; // waiting for a checkpoint
+  // first free map page, HEADER_PAGE_ID if none; protected by header_latch_
+  page_id_t free_map_root_;
+  // serializes writes of the header page with updates of its trailer
+  std::mutex header_latch_;
   int num_flushes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
@@ -5,14 +5,34 @@
  * Functionality: The buffer pool manager must maintain a page table to be able
  * to quickly map a PageId to its corresponding memory location; or alternately
  * report that the PageId does not match any currently-buffered page.
+ *
+ * Remove coalesces a bucket with its buddy once both fit into one bucket, and
+ * the directory halves its global depth when no bucket needs the top bit. A
+ * directory left at a quarter of its capacity or less is copied into one half
+ * as large, so the footprint follows the live key count after a burst of
+ * churn.
+ *
+ * Concurrency: writers are serialized by `latch`. A split or merge runs
+ * between two bumps of `version` while holding the latches of the buckets it
+ * touches; it redirects directory slots in place, or publishes a copy twice as
+ * large when the directory runs out of room. Find and Remove never take
+ * `latch`: they read the current directory, lock the bucket and validate that
+ * `version` did not move in between, falling back to `latch` only when a
+ * split or merge got in the way. While a reader holds a directory pointer it
+ * is counted in one of a few striped reader slots; a replaced directory is
+ * freed by the next writer that finds every slot at zero. Bucket shells are
+ * never freed, so a late reader can always lock one; merged away buckets drop
+ * their slot arrays and are reused by later splits.
  */
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
 #include <vector>
 #include <string>
-#include <map>
+#include <memory>
 #include <mutex>
 
 #include "hash/hash_table.h"
@@ -23,12 +43,45 @@ namespace cmudb {
 
     template <typename K, typename V>
     class ExtendibleHash : public HashTable<K, V> {
+        // flat bucket: keys and values live in two arrays of bucketSize
+        // slots, the first `size` of them in use. A lookup scans the dense
+        // key array only, which for small keys is a couple of cache lines
         struct Bucket {
-            Bucket(int depth) : localDepth(depth) {};
+            Bucket(int depth, size_t capacity)
+                    : localDepth(depth), size(0), keys(new K[capacity]),
+                      values(new V[capacity]) {};
+            // slot holding key, or -1
+            int IndexOf(const K &key) const {
+                int idx = -1;
+                // no early exit, the loop compiles to a branch free scan
+                for (size_t i = 0; i < size; i++) {
+                    idx = keys[i] == key ? static_cast<int>(i) : idx;
+                }
+                return idx;
+            }
             int localDepth;
-            map<K, V> mp;
+            size_t size;
+            unique_ptr<K[]> keys;
+            unique_ptr<V[]> values;
             mutable mutex latch;
         };
+        // slots are updated in place by splits and merges; the global depth
+        // moves within capacity, a directory that outgrows it is copied
+        struct Directory {
+            Directory(int depth, size_t cap)
+                    : globalDepth(depth), capacity(cap),
+                      slots(new atomic<Bucket *>[cap]) {};
+            size_t Size() const { return 1u << globalDepth.load(memory_order_acquire); }
+            atomic<int> globalDepth;
+            size_t capacity;
+            unique_ptr<atomic<Bucket *>[]> slots;
+        };
+        // readers that may dereference a directory, striped by thread
+        struct ReaderSlot {
+            atomic<uint32_t> active{0};
+            char padding[64 - sizeof(atomic<uint32_t>)]; // one per cache line
+        };
+        static const size_t READER_SLOTS = 16;
         public:
             // constructor
             ExtendibleHash(size_t size);
@@ -38,19 +91,32 @@ namespace cmudb {
             int GetGlobalDepth() const;
             int GetLocalDepth(int bucket_id) const;
             int GetNumBuckets() const;
+            // helper function to get the directory footprint
+            size_t GetDirectoryCapacity() const;
+            size_t GetDirectoryCount() const;
             // lookup and modifier
             bool Find(const K &key, V &value) override;
             bool Remove(const K &key) override;
             void Insert(const K &key, const V &value) override;
 
         private:
-            // add your own member variables here
-            int globalDepth;
             size_t bucketSize;
-            int bucketNum;
-            vector<shared_ptr<Bucket>> buckets;
-            mutable mutex latch;
+            int bucketNum;                          // protected by latch
+            atomic<Directory *> directory;          // current directory
+            atomic<uint64_t> version;               // odd while a split is published
+            vector<unique_ptr<Directory>> directories; // current one last, the
+                                                       // others wait for reclaim
+            ReaderSlot readers[READER_SLOTS];
+            vector<unique_ptr<Bucket>> bucketStore; // owns every bucket
+            vector<Bucket *> retiredBuckets;        // merged away, free for reuse
+            vector<int> depthCount;                 // number of buckets per local depth
+            mutable mutex latch;                    // serializes writers
 
-            int getIdx(const K &key);
+            int getIdx(const Directory *dir, const K &key);
+            Bucket *lockBucket(const K &key, unique_lock<mutex> &bucketLock);
+            void publish(Directory *dir);
+            void reclaim();
+            Bucket *newBucket(int depth);
+            void coalesce(const K &key);
     };
 } // namespace cmudb
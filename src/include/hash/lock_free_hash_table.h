@@ -0,0 +1,72 @@
+/*
+ * lock_free_hash_table.h : fixed capacity open addressing hash table with
+ * lock-free lookups
+ *
+ * Functionality: page table of a buffer pool instance. The number of entries
+ * never exceeds the number of frames, so the slot array is allocated once
+ * (at least twice the expected size, rounded up to a power of two) and never
+ * resized. Keys are placed with linear probing from a multiplicative hash.
+ *
+ * Find never takes a lock: it reads the slots optimistically and validates
+ * the read against a version counter that writers bump to an odd value before
+ * they touch any slot and back to even afterwards (seqlock). Insert and Remove
+ * are serialized by a mutex; Remove shifts the following entries of the probe
+ * run back instead of leaving tombstones, so probe runs never degrade.
+ * K and V must be trivially copyable.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "hash/hash_table.h"
+
+namespace cmudb {
+
+    template<typename K, typename V>
+    class LockFreeHashTable : public HashTable<K, V> {
+        struct Slot {
+            std::atomic<bool> used;
+            std::atomic<K> key;
+            std::atomic<V> value;
+        };
+
+    public:
+        // size: maximum number of entries the table has to hold
+        explicit LockFreeHashTable(size_t size);
+
+        ~LockFreeHashTable();
+
+        LockFreeHashTable(const LockFreeHashTable &) = delete;
+
+        LockFreeHashTable &operator=(const LockFreeHashTable &) = delete;
+
+        // lookup and modifier
+        bool Find(const K &key, V &value) override;
+
+        bool Remove(const K &key) override;
+
+        void Insert(const K &key, const V &value) override;
+
+        inline size_t GetCapacity() const { return capacity_; }
+
+        size_t GetSize();
+
+    private:
+        size_t HomeSlot(const K &key) const;
+
+        // writer side of the seqlock, caller must hold latch
+        void BeginWrite();
+
+        void EndWrite();
+
+        size_t capacity_; // power of two
+        int shift_;       // 64 - log2(capacity_)
+        size_t size_;     // protected by latch
+        Slot *slots_;
+        std::atomic<uint64_t> version_;
+        std::mutex latch; // serializes writers
+    };
+} // namespace cmudb
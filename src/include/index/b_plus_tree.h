@@ -60,14 +60,20 @@ namespace cmudb {
         void RemoveFromFile(const std::string &file_name,
                             Transaction *transaction = nullptr);
         // expose for test purpose
+        // read-only descent, the read latch of a parent is held until the
+        // child is latched; the guard of the leaf is returned
+        ReadPageGuard FindLeafPageRead(const KeyType &key, bool leftMost = false);
+
+        // descent of an insert or delete, the latched pages stay in the
+        // transaction's page set until the operation is done
         B_PLUS_TREE_LEAF_PAGE_TYPE *FindLeafPage(const KeyType &key,
-                                                 bool leftMost = false,
-                                                 BTreeOpType op = BTreeOpType::READ,
-                                                 Transaction *transaction = nullptr);
+                                                 bool leftMost,
+                                                 BTreeOpType op,
+                                                 Transaction *transaction);
 
-        BPlusTreePage *CrabbingFetchPage(page_id_t child, page_id_t parent, BTreeOpType op, Transaction *transaction);
+        BPlusTreePage *CrabbingFetchPage(page_id_t child, BTreeOpType op, Transaction *transaction);
 
-        void FreePagesInTransaction(bool exclusive, bool findLeafPageOngoing, Transaction *transaction);
+        void FreePagesInTransaction(bool findLeafPageOngoing, Transaction *transaction);
 
     private:
         void StartNewTree(const KeyType &key, const ValueType &value);
@@ -94,7 +100,10 @@ namespace cmudb {
         template<typename N>
         void Redistribute(N *neighbor_node, N *node, int index);
 
-        bool AdjustRoot(BPlusTreePage *node);
+        bool AdjustRoot(BPlusTreePage *node, Transaction *transaction);
+
+        // guard of a page already latched by this operation, nullptr if none
+        WritePageGuard *HeldPage(page_id_t page_id, Transaction *transaction);
 
         void UpdateRootPageId(int insert_record = false);
 
@@ -3,6 +3,8 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <utility>
+
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace cmudb {
@@ -15,14 +17,12 @@ class IndexIterator {
 public:
   // you may define your own constructor based on your member variables
   IndexIterator();
-  IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *firstLeafPage, BufferPoolManager *bufferPoolManager, int idx) : cur_leaf_page_(firstLeafPage), buffer_pool_manager_(bufferPoolManager), index_(idx){
-      // redundant pin here. The first pin happens at FindLeafPage() as well as the Latch.
-      if(cur_leaf_page_ != nullptr) {
-          raw_page_ = buffer_pool_manager_->FetchPage(cur_leaf_page_->GetPageId());
-          bufferPoolManager->UnpinPage(cur_leaf_page_->GetPageId(), false);
-          assert(raw_page_->GetPinCount()>0);
-      }
+  // takes over the read guard of the first leaf, an empty guard is the end
+  IndexIterator(ReadPageGuard &&leafGuard, BufferPoolManager *bufferPoolManager, int idx)
+      : guard_(std::move(leafGuard)), buffer_pool_manager_(bufferPoolManager), index_(idx) {
+      cur_leaf_page_ = guard_.IsValid() ? guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>() : nullptr;
   }
+  IndexIterator(IndexIterator &&other) = default;
   ~IndexIterator();
 
   bool isEnd() {
@@ -37,14 +37,13 @@ public:
       index_++;
       if(index_>=cur_leaf_page_->GetSize()){
           page_id_t nextPageId = cur_leaf_page_->GetNextPageId();
-          raw_page_->UnLatch(false);
-          buffer_pool_manager_->UnpinPage(cur_leaf_page_->GetPageId(), false);
-          if(nextPageId == INVALID_PAGE_ID) {
-              cur_leaf_page_ = nullptr;
-          } else {
-              raw_page_ = buffer_pool_manager_->FetchPage(nextPageId);
-              raw_page_->Latch(false);
-              cur_leaf_page_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(raw_page_->GetData());
+          // never wait for the next leaf while holding this one, writers
+          // latch siblings right to left
+          guard_.Release();
+          cur_leaf_page_ = nullptr;
+          if(nextPageId != INVALID_PAGE_ID) {
+              guard_ = buffer_pool_manager_->FetchPageRead(nextPageId);
+              cur_leaf_page_ = guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
               index_ = 0;
           }
       }
@@ -53,7 +52,7 @@ public:
 
 private:
   // add your own private member variables here
-  Page *raw_page_;
+  ReadPageGuard guard_;
   B_PLUS_TREE_LEAF_PAGE_TYPE *cur_leaf_page_;
   BufferPoolManager *buffer_pool_manager_;
   int index_;
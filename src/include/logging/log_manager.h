@@ -20,10 +20,11 @@ class LogManager {
 public:
   LogManager(DiskManager *disk_manager)
       : next_lsn_(0), persistent_lsn_(INVALID_LSN),
+        log_buffer_size_(LOG_BUFFER_PAGES * disk_manager->GetPageSize()),
         disk_manager_(disk_manager) {
     // TODO: you may intialize your own defined memeber variables here
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+    log_buffer_ = new char[log_buffer_size_];
+    flush_buffer_ = new char[log_buffer_size_];
   }
 
   ~LogManager() {
@@ -43,6 +44,8 @@ public:
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
   inline char *GetLogBuffer() { return log_buffer_; }
+  // follows the page size of the database file
+  inline size_t GetLogBufferSize() const { return log_buffer_size_; }
 
 private:
   // TODO: you may add your own member variables
@@ -53,6 +56,7 @@ private:
   // log records before & include persistent_lsn_ have been written to disk
   std::atomic<lsn_t> persistent_lsn_;
   // log buffer related
+  size_t log_buffer_size_;
   char *log_buffer_;
   char *flush_buffer_;
   // latch to protect shared member variables
@@ -19,9 +19,10 @@ public:
   LogRecovery(DiskManager *disk_manager,
                     BufferPoolManager *buffer_pool_manager)
       : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager),
-        offset_(0) {
+        offset_(0),
+        log_buffer_size_(LOG_BUFFER_PAGES * disk_manager->GetPageSize()) {
     // global transaction through recovery phase
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
+    log_buffer_ = new char[log_buffer_size_];
   }
 
   ~LogRecovery() {
@@ -44,6 +45,7 @@ private:
   std::unordered_map<lsn_t, int> lsn_mapping_;
   // log buffer related
   int offset_;
+  size_t log_buffer_size_;
   char *log_buffer_;
 };
 
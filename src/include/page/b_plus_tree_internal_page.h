@@ -31,7 +31,7 @@ INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
 public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, page_id_t parent_id, size_t page_size);
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
@@ -0,0 +1,51 @@
+/**
+ * free_map_page.h
+ *
+ * Free map pages record which pages of the database file are free. Each one
+ * holds a bitmap over a fixed range of page ids: free map page i covers ids
+ * [i * capacity, (i + 1) * capacity), a set bit marks a free page. They are
+ * chained through NextPageId, the header page records the first one (see
+ * header_page.h).
+ *
+ * A free map page lives in the page id space it describes but never in the
+ * buffer pool: DiskManager creates one from the first page freed in a range
+ * that has none yet, and reads and writes them itself.
+ *
+ * Format (size in byte):
+ *  ----------------------------------------------------------------------
+ * | Magic (4) | Index (4) | NextPageId (4) | Reserved (4) | Bitmap ... |
+ *  ----------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class FreeMapPage {
+public:
+  static const uint32_t MAGIC;
+  static const int BITMAP_OFFSET = 16;
+
+  // number of page ids one free map page of page_size bytes covers
+  static inline size_t GetCapacity(size_t page_size) {
+    return (page_size - BITMAP_OFFSET) * 8;
+  }
+
+  // write an empty free map page of page_size bytes to data
+  static void Format(char *data, size_t page_size, uint32_t index,
+                     page_id_t next_page_id);
+  static bool IsFreeMapPage(const char *data);
+  static uint32_t GetIndex(const char *data);
+  static page_id_t GetNextPageId(const char *data);
+
+  // bit of page_id, which must lie in the range of this page
+  static bool IsFree(const char *data, size_t page_size, page_id_t page_id);
+  static void SetFree(char *data, size_t page_size, page_id_t page_id,
+                      bool is_free);
+};
+} // namespace cmudb
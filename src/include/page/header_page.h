@@ -3,12 +3,26 @@
  *
  * Database use the first page (page_id = 0) as header page to store metadata, in
  * our case, we will contain information about table/index name (length less than
- * 32 bytes) and their corresponding root_id
+ * 32 bytes) and their corresponding root_id. It also records the page size of
+ * the database file, which DiskManager reads back when the file is opened.
  *
  * Format (size in byte):
- *  -----------------------------------------------------------------
- * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
- *  -----------------------------------------------------------------
+ *  ----------------------------------------------------------------------------
+ * | Magic (4) | Version (4) | PageSize (4) | RecordCount (4) | Entry_1 name (32)
+ *  ----------------------------------------------------------------------------
+ * | Entry_1 root_id (4) | ...                                  | FreeMapPageId (4)
+ *  ----------------------------------------------------------------------------
+ *
+ * The last four bytes of the page belong to DiskManager: the first free map
+ * page of the file (see free_map_page.h), 0 if there is none. DiskManager
+ * stamps its current value into every write of the header page, so the copy
+ * in the buffer pool never has to know it.
+ *
+ * Legacy files, written before the page size was recorded, have no magic:
+ * they start with RecordCount, the entries follow at byte 4 and their page
+ * size is the old compile-time PAGE_SIZE. DiskManager rewrites such a header
+ * page in this format when it opens the file (see UpgradeLegacy), and refuses
+ * the file if its records do not fit any more.
  */
 
 #pragma once
@@ -21,7 +35,30 @@ namespace cmudb {
 
 class HeaderPage : public Page {
 public:
-  void Init() { SetRecordCount(0); }
+  static const uint32_t MAGIC;   // first four bytes of every header page
+  static const uint32_t VERSION; // layout version written by Init
+  static const int RECORDS_OFFSET = 16;
+  static const int RECORD_SIZE = 36;
+  static const int FREE_MAP_SIZE = 4; // the FreeMapPageId trailer
+
+  void Init() { Format(GetData(), GetPageSize()); }
+
+  /**
+   * Raw page helpers, used by DiskManager before any buffer pool exists
+   */
+  // write an empty header page of page_size bytes to data
+  static void Format(char *data, size_t page_size);
+  static bool HasMagic(const char *data);
+  static uint32_t ReadVersion(const char *data);
+  static size_t ReadPageSize(const char *data);
+  // 0 (the header page itself) stands for no free map
+  static page_id_t ReadFreeMapPageId(const char *data, size_t page_size);
+  static void WriteFreeMapPageId(char *data, size_t page_size,
+                                 page_id_t page_id);
+  // convert the legacy header page in legacy (PAGE_SIZE bytes) into a header
+  // page of PAGE_SIZE bytes in data, false if the records do not fit
+  static bool UpgradeLegacy(const char *legacy, char *data);
+
   /**
    * Record related
    */
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -20,10 +21,13 @@ class Page {
   friend class BufferPoolManager;
 
 public:
-  Page() { ResetMemory(); }
+  // the data area is assigned by the buffer pool manager
+  Page() {}
   ~Page(){};
   // get actual data page content
   inline char *GetData() { return data_; }
+  // size of the data area, fixed per database file
+  inline size_t GetPageSize() { return page_size_; }
   // get page id
   inline page_id_t GetPageId() { return page_id_; }
   // get page pin count
@@ -33,6 +37,7 @@ public:
   inline void WLatch() { rwlatch_.WLock(); }
   inline void RUnlatch() { rwlatch_.RUnlock(); }
   inline void RLatch() { rwlatch_.RLock(); }
+  inline bool TryRLatch() { return rwlatch_.TryRLock(); }
   inline void Latch(bool exclusive) {
       if(exclusive) {
           WLatch();
@@ -53,12 +58,19 @@ public:
 
 private:
   // method used by buffer pool manager
-  inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
+  inline void ResetMemory() { memset(data_, 0, page_size_); }
   // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
-  bool is_dirty_ = false;
+  char *data_ = nullptr; // actual data, a frame of the pool's FrameRegion
+  size_t page_size_ = 0;
+  // read by the latch-free pin/unpin fast path. They change under the
+  // instance latch, except that the fast path moves a pin count that stays
+  // above zero and sets is_dirty_
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  std::atomic<int> pin_count_{0};
+  std::atomic<bool> is_dirty_{false};
+  bool is_flushing_ = false; // background write in progress
+  uint64_t last_used_ = 0;   // pool access clock at the last unpin to zero
+  std::atomic<bool> is_loading_{false}; // read in progress, write latch held
   RWMutex rwlatch_;
 };
 
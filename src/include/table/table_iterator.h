@@ -40,9 +40,13 @@ public:
   TableIterator operator++(int);
 
 private:
+  void ReadAhead(page_id_t cur_page_id, page_id_t next_page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  // end of the last requested read-ahead window (exclusive)
+  page_id_t read_ahead_end_;
 };
 
 } // namespace cmudb
\ No newline at end of file
@@ -59,11 +59,38 @@ int VtabCommit(sqlite3_vtab *pVTab);
 
 int VtabBegin(sqlite3_vtab *pVTab);
 
+/* bustub_buffer_stats: read-only eponymous table with one (name, value) row
+ * per buffer pool counter, e.g. SELECT * FROM bustub_buffer_stats */
+int BufferStatsConnect(sqlite3 *db, void *pAux, int argc,
+                       const char *const *argv, sqlite3_vtab **ppVtab,
+                       char **pzErr);
+
+int BufferStatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo);
+
+int BufferStatsDisconnect(sqlite3_vtab *pVtab);
+
+int BufferStatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor);
+
+int BufferStatsClose(sqlite3_vtab_cursor *cur);
+
+int BufferStatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                      const char *idxStr, int argc, sqlite3_value **argv);
+
+int BufferStatsNext(sqlite3_vtab_cursor *cur);
+
+int BufferStatsEof(sqlite3_vtab_cursor *cur);
+
+int BufferStatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i);
+
+int BufferStatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid);
+
 // storage engine
 class StorageEngine {
 public:
   StorageEngine(std::string db_file_name) {
     ENABLE_LOGGING = false;
+    // resident pages are dumped next to the database file
+    warm_up_file_name_ = db_file_name.substr(0, db_file_name.find('.')) + ".warm";
 
     // storage related
     disk_manager_ = new DiskManager(db_file_name);
@@ -82,8 +109,10 @@ public:
   ~StorageEngine() {
     if (ENABLE_LOGGING)
       log_manager_->StopFlushThread();
-    delete disk_manager_;
+    buffer_pool_manager_->DumpResidentPages(warm_up_file_name_);
+    // the pool's background threads use the disk manager until it is gone
     delete buffer_pool_manager_;
+    delete disk_manager_;
     delete log_manager_;
     delete lock_manager_;
     delete transaction_manager_;
@@ -94,6 +123,7 @@ public:
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
+  std::string warm_up_file_name_;
 };
 
 StorageEngine *storage_engine_;
@@ -3,6 +3,7 @@
  */
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -42,14 +43,16 @@ namespace cmudb {
     bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
                                   std::vector<ValueType> &result,
                                   Transaction *transaction) {
-        auto *leafPage = FindLeafPage(key);
-        if(leafPage == nullptr) {
+        ReadPageGuard leafGuard = FindLeafPageRead(key);
+        if (!leafGuard.IsValid()) {
             return false;
         }
-        assert(!result.empty());
-        bool ans = leafPage->Lookup(key, result[0], comparator_);
-        FreePagesInTransaction(false, false, transaction);
-        return ans;
+        ValueType value;
+        if (!leafGuard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>()->Lookup(key, value, comparator_)) {
+            return false;
+        }
+        result.push_back(value);
+        return true;
     }
 
 /*****************************************************************************
@@ -85,17 +88,16 @@ namespace cmudb {
     void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
         // page initialization
         page_id_t pageId;
-        Page &page = *(buffer_pool_manager_->NewPage(pageId));
-        assert((&page) != nullptr);
+        WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(pageId);
+        assert(guard.IsValid());
 
         // b+ tree initialization
-        B_PLUS_TREE_LEAF_PAGE_TYPE &root = *(reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page.GetData()));
-        root.Init(pageId, INVALID_PAGE_ID);
-        root.Insert(key, value, comparator_);
+        auto *root = guard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+        root->Init(pageId, INVALID_PAGE_ID, buffer_pool_manager_->GetPageSize());
+        root->Insert(key, value, comparator_);
         // update root page id
         root_page_id_ = pageId;
         UpdateRootPageId(true);
-        buffer_pool_manager_->UnpinPage(pageId, true);
     }
 
 /*
@@ -114,7 +116,7 @@ namespace cmudb {
         ValueType v;
         bool containsKey = leafPage->Lookup(key, v, comparator_);
         if (containsKey) {
-            FreePagesInTransaction(true, false, transaction);
+            FreePagesInTransaction(false, transaction);
             return false;
         }
         leafPage->Insert(key, value, comparator_);
@@ -122,7 +124,7 @@ namespace cmudb {
             auto *splittedRightPage = Split(leafPage, transaction);
             InsertIntoParent(leafPage, splittedRightPage->KeyAt(0), splittedRightPage, transaction);
         }
-        FreePagesInTransaction(true, false, transaction);
+        FreePagesInTransaction(false, transaction);
         return true;
     }
 
@@ -137,12 +139,14 @@ namespace cmudb {
     template<typename N>
     N *BPLUSTREE_TYPE::Split(N *node, Transaction *transaction) {
         page_id_t newPageId;
-        auto *rawPage = buffer_pool_manager_->NewPage(newPageId);
-        assert(rawPage != nullptr);
-        rawPage->Latch(true);
-        transaction->AddIntoPageSet(rawPage);
-        N *btreeNode = reinterpret_cast<N *>(rawPage->GetData());
-        btreeNode->Init(newPageId, node->GetParentPageId());
+        // keep the sibling close to node on disk, scans read them in order
+        WritePageGuard guard =
+                buffer_pool_manager_->NewPageGuarded(newPageId, node->GetPageId());
+        assert(guard.IsValid());
+        N *btreeNode = guard.As<N>();
+        btreeNode->Init(newPageId, node->GetParentPageId(),
+                        buffer_pool_manager_->GetPageSize());
+        transaction->AddIntoPageSet(std::move(guard));
         node->MoveHalfTo(btreeNode, buffer_pool_manager_);
         return btreeNode;
     }
@@ -163,30 +167,28 @@ namespace cmudb {
                                           Transaction *transaction) {
         if (old_node->IsRootPage()) {
             page_id_t pageId;
-            Page *rawPage = buffer_pool_manager_->NewPage(pageId);
-            assert(rawPage != nullptr);
-            auto newRootPage = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(rawPage->GetData());
-            newRootPage->Init(pageId, INVALID_PAGE_ID);
+            WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(pageId);
+            assert(guard.IsValid());
+            auto *newRootPage = guard.As<B_PLUS_TREE_INTERNAL_PAGE>();
+            newRootPage->Init(pageId, INVALID_PAGE_ID,
+                              buffer_pool_manager_->GetPageSize());
             newRootPage->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
             new_node->SetParentPageId(pageId);
             old_node->SetParentPageId(pageId);
             root_page_id_ = pageId;
             UpdateRootPageId();
-            buffer_pool_manager_->UnpinPage(pageId, true);
             return;
         }
-        page_id_t pageId = old_node->GetParentPageId();
-        // second pin
-        auto *rawPage = buffer_pool_manager_->FetchPage(pageId);
-        assert(rawPage != nullptr);
-        new_node->SetParentPageId(pageId);
-        auto *internalPage = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(rawPage->GetData());
+        // old_node was full, so the crabbing kept its parent latched
+        WritePageGuard *parentGuard = HeldPage(old_node->GetParentPageId(), transaction);
+        assert(parentGuard != nullptr);
+        auto *internalPage = parentGuard->As<B_PLUS_TREE_INTERNAL_PAGE>();
+        new_node->SetParentPageId(internalPage->GetPageId());
         internalPage->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
         if (internalPage->GetSize() > internalPage->GetMaxSize()) {
-            auto *splittedRightPage = Split(internalPage);
+            auto *splittedRightPage = Split(internalPage, transaction);
             InsertIntoParent(internalPage, splittedRightPage->KeyAt(0), splittedRightPage, transaction);
         }
-        buffer_pool_manager_->UnpinPage(pageId, true);
     }
 
 /*****************************************************************************
@@ -211,14 +213,14 @@ namespace cmudb {
         ValueType v;
         bool containsKey = bTreeLeafNode->Lookup(key, v, comparator_);
         if (!containsKey) {
-            FreePagesInTransaction(true, false, transaction);
+            FreePagesInTransaction(false, transaction);
             return;
         }
         bTreeLeafNode->RemoveAndDeleteRecord(key, comparator_);
         if(bTreeLeafNode->GetSize() < bTreeLeafNode->GetMinSize()) {
             CoalesceOrRedistribute(bTreeLeafNode, transaction);
         }
-        FreePagesInTransaction(true, false, transaction);
+        FreePagesInTransaction(false, transaction);
     }
 
 /*
@@ -231,69 +233,52 @@ namespace cmudb {
     template<typename N>
     bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
         if(node->IsRootPage()) {
-            bool deleteRoot = AdjustRoot(node);
+            bool deleteRoot = AdjustRoot(node, transaction);
             assert(deleteRoot);
             transaction->AddIntoDeletedPageSet(node->GetPageId());
             return true;
         }
-        // fetch twice. MUST unpin.
-        Page *rawParentPage = buffer_pool_manager_ -> FetchPage(node->GetParentPageId());
-        assert(rawParentPage!= nullptr);
-        auto *bTreeParentNode = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(rawParentPage -> GetData());
+        // node is below its min size, so the crabbing kept its parent latched
+        WritePageGuard *parentGuard = HeldPage(node->GetParentPageId(), transaction);
+        assert(parentGuard != nullptr);
+        auto *bTreeParentNode = parentGuard->As<B_PLUS_TREE_INTERNAL_PAGE>();
         int in_parent_idx = bTreeParentNode -> ValueIndex(node->GetPageId());
-        Page *rawLeftSiblingPage = nullptr, *rawRightSiblingPage = nullptr;
+        WritePageGuard leftSiblingGuard, rightSiblingGuard;
         N *bTreeLeftSiblingNode = nullptr, *bTreeRightSiblingNode = nullptr;
         if(in_parent_idx > 0) {
-            rawLeftSiblingPage = buffer_pool_manager_ -> FetchPage(bTreeParentNode -> ValueAt(in_parent_idx-1));
-            rawLeftSiblingPage->Latch(true);
-            bTreeLeftSiblingNode = reinterpret_cast<N *>(rawLeftSiblingPage -> GetData());
+            leftSiblingGuard = buffer_pool_manager_->FetchPageWrite(bTreeParentNode->ValueAt(in_parent_idx-1));
+            assert(leftSiblingGuard.IsValid());
+            bTreeLeftSiblingNode = leftSiblingGuard.As<N>();
             if(bTreeLeftSiblingNode->GetSize() > bTreeLeftSiblingNode->GetMinSize()) {
-                transaction->AddIntoPageSet(rawLeftSiblingPage);
-                buffer_pool_manager_-> UnpinPage(bTreeParentNode->GetPageId(), false);
+                transaction->AddIntoPageSet(std::move(leftSiblingGuard));
                 Redistribute(bTreeLeftSiblingNode, node, in_parent_idx);
-                assert(rawParentPage->GetPinCount()>0);
                 return false;
             }
         }
         if(in_parent_idx < bTreeParentNode->GetSize()-1) {
-            rawRightSiblingPage = buffer_pool_manager_ -> FetchPage(bTreeParentNode -> ValueAt(in_parent_idx+1));
-            rawRightSiblingPage->Latch(true);
-            bTreeRightSiblingNode = reinterpret_cast<N *>(rawRightSiblingPage -> GetData());
+            rightSiblingGuard = buffer_pool_manager_->FetchPageWrite(bTreeParentNode->ValueAt(in_parent_idx+1));
+            assert(rightSiblingGuard.IsValid());
+            bTreeRightSiblingNode = rightSiblingGuard.As<N>();
             if(bTreeRightSiblingNode->GetSize() > bTreeRightSiblingNode->GetMinSize()) {
-                if(bTreeLeftSiblingNode!= nullptr) {
-                    rawLeftSiblingPage->UnLatch(true);
-                    buffer_pool_manager_->UnpinPage(bTreeLeftSiblingNode->GetPageId(), false);
-                }
-                transaction->AddIntoPageSet(rawRightSiblingPage);
-                buffer_pool_manager_-> UnpinPage(bTreeParentNode->GetPageId(), false);
+                leftSiblingGuard.Release();
+                transaction->AddIntoPageSet(std::move(rightSiblingGuard));
                 Redistribute(bTreeRightSiblingNode, node, 0);
-                assert(rawParentPage->GetPinCount()>0);
                 return false;
             }
         }
 
-        // Coalesce
+        // Coalesce, the sibling that is not merged is released untouched
         if(in_parent_idx > 0) {
-            assert(rawLeftSiblingPage != nullptr && bTreeLeftSiblingNode!= nullptr && rawLeftSiblingPage->GetPageId()==bTreeLeftSiblingNode->GetPageId());
-            if(bTreeRightSiblingNode != nullptr) {
-                assert(rawRightSiblingPage!= nullptr && rawRightSiblingPage->GetPageId() == bTreeRightSiblingNode->GetPageId());
-                rawRightSiblingPage->UnLatch(true);
-                buffer_pool_manager_->UnpinPage(bTreeRightSiblingNode->GetPageId(), false);
-            }
-            transaction->AddIntoPageSet(rawLeftSiblingPage);
-            buffer_pool_manager_-> UnpinPage(bTreeParentNode->GetPageId(), false);
-            assert(rawParentPage->GetPinCount()>0);
+            assert(bTreeLeftSiblingNode != nullptr);
+            rightSiblingGuard.Release();
+            transaction->AddIntoPageSet(std::move(leftSiblingGuard));
             Coalesce(bTreeLeftSiblingNode, node, bTreeParentNode, in_parent_idx, transaction);
-            return true;
         } else {
-            assert(rawRightSiblingPage != nullptr && bTreeRightSiblingNode != nullptr && rawRightSiblingPage->GetPageId()==bTreeRightSiblingNode->GetPageId());
-            assert(rawLeftSiblingPage == nullptr && bTreeLeftSiblingNode==nullptr);
-            transaction->AddIntoPageSet(rawLeftSiblingPage);
-            buffer_pool_manager_-> UnpinPage(bTreeParentNode->GetPageId(), false);
-            assert(rawParentPage->GetPinCount()>0);
+            assert(bTreeRightSiblingNode != nullptr);
+            transaction->AddIntoPageSet(std::move(rightSiblingGuard));
             Coalesce(node, bTreeRightSiblingNode, bTreeParentNode, in_parent_idx+1, transaction);
-            return true;
         }
+        return true;
     }
 
 /*
@@ -355,7 +340,7 @@ namespace cmudb {
  * happend
  */
     INDEX_TEMPLATE_ARGUMENTS
-    bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
+    bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node, Transaction *transaction) {
         if(old_root_node->IsLeafPage()) {
             //case 2
             root_page_id_ = INVALID_PAGE_ID;
@@ -366,11 +351,18 @@ namespace cmudb {
         assert(old_root_node->GetSize()==1);
         auto *bTreeInternalNode = static_cast<B_PLUS_TREE_INTERNAL_PAGE *>(old_root_node);
         page_id_t newRootId = bTreeInternalNode->RemoveAndReturnOnlyChild();
-        auto *rawPage = buffer_pool_manager_->FetchPage(newRootId);
-        assert(rawPage != nullptr);
-        auto *newBTreeRootNode = reinterpret_cast<BPlusTreePage *>(rawPage->GetData());
-        newBTreeRootNode -> SetParentPageId(INVALID_PAGE_ID);
-        buffer_pool_manager_->UnpinPage(newRootId, true);
+        // the only child is the node merged into, latched by this operation
+        WritePageGuard *childGuard = HeldPage(newRootId, transaction);
+        WritePageGuard guard;
+        if (childGuard == nullptr) {
+            guard = buffer_pool_manager_->FetchPageWrite(newRootId);
+            assert(guard.IsValid());
+            guard.MarkDirty();
+            childGuard = &guard;
+        }
+        childGuard->As<BPlusTreePage>()->SetParentPageId(INVALID_PAGE_ID);
+        root_page_id_ = newRootId;
+        UpdateRootPageId();
         return true;
     }
 
@@ -385,9 +377,7 @@ namespace cmudb {
     INDEX_TEMPLATE_ARGUMENTS
     INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
         KeyType dummy;
-        auto *firstLeafPage = FindLeafPage(dummy, true);
-        TryUnlockRootPageId(false);
-        return INDEXITERATOR_TYPE(firstLeafPage, buffer_pool_manager_, 0);
+        return INDEXITERATOR_TYPE(FindLeafPageRead(dummy, true), buffer_pool_manager_, 0);
     }
 
 /*
@@ -397,13 +387,12 @@ namespace cmudb {
  */
     INDEX_TEMPLATE_ARGUMENTS
     INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-        auto *firstLeafPage = FindLeafPage(key);
-        TryUnlockRootPageId(false);
-        if(firstLeafPage == nullptr) {
-            return INDEXITERATOR_TYPE(nullptr, buffer_pool_manager_, 0);
+        ReadPageGuard leafGuard = FindLeafPageRead(key);
+        int idx = 0;
+        if (leafGuard.IsValid()) {
+            idx = leafGuard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>()->KeyIndex(key, comparator_);
         }
-        int idx = firstLeafPage->KeyIndex(key, comparator_);
-        return INDEXITERATOR_TYPE(firstLeafPage, buffer_pool_manager_, idx);
+        return INDEXITERATOR_TYPE(std::move(leafGuard), buffer_pool_manager_, idx);
     }
 
 /*****************************************************************************
@@ -411,71 +400,100 @@ namespace cmudb {
  *****************************************************************************/
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
- * the left most leaf page
+ * the left most leaf page. Readers hold at most two read latches at a time
+ */
+    INDEX_TEMPLATE_ARGUMENTS
+    ReadPageGuard BPLUSTREE_TYPE::FindLeafPageRead(const KeyType &key, bool leftMost) {
+        LockRootPageId(false);
+        if (IsEmpty()) {
+            TryUnlockRootPageId(false);
+            return ReadPageGuard();
+        }
+        ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(root_page_id_);
+        // the root cannot be replaced while its latch is held
+        TryUnlockRootPageId(false);
+        assert(guard.IsValid());
+        auto *bTreeNode = guard.As<BPlusTreePage>();
+        while (!bTreeNode->IsLeafPage()) {
+            auto *internalNode = static_cast<B_PLUS_TREE_INTERNAL_PAGE *>(bTreeNode);
+            page_id_t child = leftMost? internalNode->ValueAt(0) : internalNode->Lookup(key, comparator_);
+            ReadPageGuard childGuard = buffer_pool_manager_->FetchPageRead(child);
+            assert(childGuard.IsValid());
+            guard = std::move(childGuard);
+            bTreeNode = guard.As<BPlusTreePage>();
+        }
+        return guard;
+    }
+
+/*
+ * Same for an insert or delete: every page of the path is write latched and
+ * its guard moved into the transaction; whenever a child is safe for op, the
+ * pages above it are released
  */
     INDEX_TEMPLATE_ARGUMENTS
     B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
                                                              bool leftMost,
                                                              BTreeOpType op,
                                                              Transaction *transaction) {
-        bool exclusive = op != BTreeOpType::READ;
-        LockRootPageId(exclusive);
+        assert(op != BTreeOpType::READ && transaction != nullptr);
+        LockRootPageId(true);
         if (IsEmpty()) {
-            TryUnlockRootPageId(exclusive);
+            TryUnlockRootPageId(true);
             return nullptr;
         }
-        auto *bTreeNode = CrabbingFetchPage(root_page_id_, -1, op, transaction);
+        auto *bTreeNode = CrabbingFetchPage(root_page_id_, op, transaction);
         while (!bTreeNode->IsLeafPage()) {
             auto *internalNode = static_cast<B_PLUS_TREE_INTERNAL_PAGE *>(bTreeNode);
             page_id_t child = leftMost? internalNode->ValueAt(0) : internalNode->Lookup(key, comparator_);
-            bTreeNode = CrabbingFetchPage(child, bTreeNode->GetPageId(), op, transaction);
+            bTreeNode = CrabbingFetchPage(child, op, transaction);
         }
         return static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(bTreeNode);
     }
 
     INDEX_TEMPLATE_ARGUMENTS
-    BPlusTreePage *BPLUSTREE_TYPE::CrabbingFetchPage(page_id_t child, page_id_t parent, BTreeOpType op, Transaction *transaction){
-        bool exclusive = op != BTreeOpType::READ;
-        auto *childRawPage = buffer_pool_manager_->FetchPage(child);
-        assert(childRawPage != nullptr);
-        childRawPage->Latch(exclusive);
-        auto *childBTreeNode = reinterpret_cast<BPlusTreePage *>(childRawPage->GetData());
+    BPlusTreePage *BPLUSTREE_TYPE::CrabbingFetchPage(page_id_t child, BTreeOpType op, Transaction *transaction){
+        WritePageGuard childGuard = buffer_pool_manager_->FetchPageWrite(child);
+        assert(childGuard.IsValid());
+        auto *childBTreeNode = childGuard.As<BPlusTreePage>();
         if(childBTreeNode ->IsSafe(op)) {
-            if(transaction == nullptr) {
-                // called by iterator
-                if(parent!=INVALID_PAGE_ID) {
-                    Page *parentRawPage = buffer_pool_manager_->FetchPage(parent);
-                    buffer_pool_manager_->UnpinPage(parentRawPage->GetPageId(), false);
-                    assert(parentRawPage->GetPinCount()>0);
-                    parentRawPage->UnLatch(exclusive);
-                    buffer_pool_manager_->UnpinPage(parentRawPage->GetPageId(), false);
-                }
-            } else {
-                FreePagesInTransaction(exclusive, true, transaction);
-            }
-        }
-        if(transaction != nullptr) {
-            transaction->AddIntoPageSet(childRawPage);
+            FreePagesInTransaction(true, transaction);
         }
+        transaction->AddIntoPageSet(std::move(childGuard));
         return childBTreeNode;
     }
 
+/*
+ * Release every page latched by the operation, deleting those it emptied.
+ * Pages released on the way down were not modified
+ */
     INDEX_TEMPLATE_ARGUMENTS
-    void BPLUSTREE_TYPE::FreePagesInTransaction(bool exclusive, bool findLeafPageOngoing, Transaction *transaction) {
+    void BPLUSTREE_TYPE::FreePagesInTransaction(bool findLeafPageOngoing, Transaction *transaction) {
         assert(transaction!= nullptr);
-        TryUnlockRootPageId(exclusive);
-        bool likelyDirty = exclusive && !findLeafPageOngoing;
-        for( Page *page : *transaction->GetPageSet()) {
-            page->UnLatch(exclusive);
-            buffer_pool_manager_->UnpinPage(page->GetPageId(), likelyDirty);
-            if(transaction->GetDeletedPageSet()->count(page->GetPageId()) > 0) {
-                buffer_pool_manager_->DeletePage(page->GetPageId());
-                transaction->GetDeletedPageSet()->erase(page->GetPageId());
+        TryUnlockRootPageId(true);
+        for (WritePageGuard &guard : *transaction->GetPageSet()) {
+            page_id_t pageId = guard.GetPageId();
+            if (!findLeafPageOngoing) {
+                guard.MarkDirty();
+            }
+            guard.Release();
+            if(transaction->GetDeletedPageSet()->count(pageId) > 0) {
+                buffer_pool_manager_->DeletePage(pageId);
+                transaction->GetDeletedPageSet()->erase(pageId);
             }
         }
         transaction->GetPageSet()->clear();
     }
 
+    INDEX_TEMPLATE_ARGUMENTS
+    WritePageGuard *BPLUSTREE_TYPE::HeldPage(page_id_t page_id, Transaction *transaction) {
+        for (WritePageGuard &guard : *transaction->GetPageSet()) {
+            if (guard.IsValid() && guard.GetPageId() == page_id) {
+                return &guard;
+            }
+        }
+        return nullptr;
+    }
+
 /*
  * Update/Insert root page id in header page(where page_id = 0, header_page is
  * defined under include/page/header_page.h)
@@ -486,15 +504,15 @@ namespace cmudb {
  */
     INDEX_TEMPLATE_ARGUMENTS
     void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-        HeaderPage *header_page = static_cast<HeaderPage *>(
-                buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+        WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+        auto *header_page = static_cast<HeaderPage *>(guard.GetPage());
         if (insert_record)
             // create a new record<index_name + root_page_id> in header_page
             header_page->InsertRecord(index_name_, root_page_id_);
         else
             // update root_page_id in header_page
             header_page->UpdateRecord(index_name_, root_page_id_);
-        buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+        guard.MarkDirty();
     }
 
 /*
@@ -17,13 +17,14 @@ namespace cmudb {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
-                                          page_id_t parent_id) {
+                                          page_id_t parent_id,
+                                          size_t page_size) {
     SetPageType(IndexPageType::INTERNAL_PAGE);
     SetSize(0);
     // -1 to reserve for an intermediate insertion
-    SetMaxSize((PAGE_SIZE-sizeof(BPlusTreeInternalPage))/sizeof(MappingType)-1);
+    SetMaxSize((page_size-sizeof(BPlusTreeInternalPage))/sizeof(MappingType)-1);
     SetParentPageId(parent_id);
-    SetParentPageId(page_id);
+    SetPageId(page_id);
 }
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
@@ -104,7 +105,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(
     const ValueType &new_value) {
     array[0].second = old_value;
     array[1].first = new_key;
-    array[2].second = new_value;
+    array[1].second = new_value;
     SetSize(2);
 }
 /*
@@ -20,11 +20,12 @@ namespace cmudb {
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id,
+                                      size_t page_size) {
     SetPageType(IndexPageType::LEAF_PAGE);
     SetSize(0);
     // -1 to reserve for an intermediate insertion
-    SetMaxSize((PAGE_SIZE-sizeof(BPlusTreeLeafPage))/sizeof(MappingType)-1);
+    SetMaxSize((page_size-sizeof(BPlusTreeLeafPage))/sizeof(MappingType)-1);
     SetPageId(page_id);
     SetParentPageId(parent_id);
     SetNextPageId(INVALID_PAGE_ID);
@@ -121,6 +122,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(
     int offset = n/2;
     recipient->CopyHalfFrom(array+offset, n-offset);
     SetSize(offset);
+    recipient->SetNextPageId(GetNextPageId());
     SetNextPageId(recipient->GetPageId());
 }
 
@@ -157,7 +159,11 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
             right = mid-1;
         }
     }
-    return right>=0 && array[right].second == value;
+    if (right < 0 || comparator(array[right].first, key) != 0) {
+        return false;
+    }
+    value = array[right].second;
+    return true;
 }
 
 /*****************************************************************************
@@ -175,7 +181,7 @@ INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
     const KeyType &key, const KeyComparator &comparator) {
   int idx = KeyIndex(key, comparator);
-  if(idx >= GetSize() || comparator(key, array[idx].first)==0) {
+  if(idx >= GetSize() || comparator(key, array[idx].first)!=0) {
       return GetSize();
   }
   Remove(idx);
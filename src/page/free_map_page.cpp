@@ -0,0 +1,55 @@
+/**
+ * free_map_page.cpp
+ */
+#include <cassert>
+#include <cstring>
+
+#include "page/free_map_page.h"
+
+namespace cmudb {
+
+const uint32_t FreeMapPage::MAGIC = 0x50414d46; // "FMAP" in the file
+
+void FreeMapPage::Format(char *data, size_t page_size, uint32_t index,
+                         page_id_t next_page_id) {
+  uint32_t reserved = 0;
+  memset(data, 0, page_size);
+  memcpy(data, &MAGIC, 4);
+  memcpy(data + 4, &index, 4);
+  memcpy(data + 8, &next_page_id, 4);
+  memcpy(data + 12, &reserved, 4);
+}
+
+bool FreeMapPage::IsFreeMapPage(const char *data) {
+  return *reinterpret_cast<const uint32_t *>(data) == MAGIC;
+}
+
+uint32_t FreeMapPage::GetIndex(const char *data) {
+  return *reinterpret_cast<const uint32_t *>(data + 4);
+}
+
+page_id_t FreeMapPage::GetNextPageId(const char *data) {
+  return *reinterpret_cast<const page_id_t *>(data + 8);
+}
+
+bool FreeMapPage::IsFree(const char *data, size_t page_size,
+                         page_id_t page_id) {
+  size_t bit = static_cast<size_t>(page_id) % GetCapacity(page_size);
+  assert(static_cast<size_t>(page_id) / GetCapacity(page_size) ==
+         GetIndex(data));
+  return (data[BITMAP_OFFSET + bit / 8] >> (bit % 8)) & 1;
+}
+
+void FreeMapPage::SetFree(char *data, size_t page_size, page_id_t page_id,
+                          bool is_free) {
+  size_t bit = static_cast<size_t>(page_id) % GetCapacity(page_size);
+  assert(static_cast<size_t>(page_id) / GetCapacity(page_size) ==
+         GetIndex(data));
+  char mask = static_cast<char>(1 << (bit % 8));
+  if (is_free) {
+    data[BITMAP_OFFSET + bit / 8] |= mask;
+  } else {
+    data[BITMAP_OFFSET + bit / 8] &= ~mask;
+  }
+}
+} // namespace cmudb
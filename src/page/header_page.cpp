@@ -8,6 +8,9 @@
 
 namespace cmudb {
 
+const uint32_t HeaderPage::MAGIC = 0x42555354; // "TSUB" in the file
+const uint32_t HeaderPage::VERSION = 1;
+
 /**
  * Record related
  */
@@ -17,9 +20,10 @@ bool HeaderPage::InsertRecord(const std::string &name,
   assert(root_id > INVALID_PAGE_ID);
 
   int record_num = GetRecordCount();
-  int offset = 4 + record_num * 36;
-  // check for duplicate name
-  if (FindRecord(name) != -1)
+  int offset = RECORDS_OFFSET + record_num * RECORD_SIZE;
+  // check for duplicate name or a full page
+  if (FindRecord(name) != -1 ||
+      offset + RECORD_SIZE > static_cast<int>(GetPageSize()) - FREE_MAP_SIZE)
     return false;
   // copy record content
   memcpy(GetData() + offset, name.c_str(), (name.length() + 1));
@@ -37,9 +41,9 @@ bool HeaderPage::DeleteRecord(const std::string &name) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
-  memmove(GetData() + offset, GetData() + offset + 36,
-          (record_num - index - 1) * 36);
+  int offset = index * RECORD_SIZE + RECORDS_OFFSET;
+  memmove(GetData() + offset, GetData() + offset + RECORD_SIZE,
+          (record_num - index - 1) * RECORD_SIZE);
 
   SetRecordCount(record_num - 1);
   return true;
@@ -53,7 +57,7 @@ bool HeaderPage::UpdateRecord(const std::string &name,
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
+  int offset = index * RECORD_SIZE + RECORDS_OFFSET;
   // update record content, only root_id
   memcpy((GetData() + offset + 32), &root_id, 4);
 
@@ -67,7 +71,7 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = (index + 1) * 36;
+  int offset = index * RECORD_SIZE + RECORDS_OFFSET + 32;
   root_id = *reinterpret_cast<page_id_t *>(GetData() + offset);
 
   return true;
@@ -77,17 +81,66 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
  * helper functions
  */
 // record count
-int HeaderPage::GetRecordCount() { return *reinterpret_cast<int *>(GetData()); }
+int HeaderPage::GetRecordCount() {
+  return *reinterpret_cast<int *>(GetData() + 12);
+}
 
 void HeaderPage::SetRecordCount(int record_count) {
-  memcpy(GetData(), &record_count, 4);
+  memcpy(GetData() + 12, &record_count, 4);
+}
+
+/**
+ * raw page helpers
+ */
+void HeaderPage::Format(char *data, size_t page_size) {
+  int size = static_cast<int>(page_size);
+  int record_count = 0;
+  memset(data, 0, RECORDS_OFFSET);
+  memcpy(data, &MAGIC, 4);
+  memcpy(data + 4, &VERSION, 4);
+  memcpy(data + 8, &size, 4);
+  memcpy(data + 12, &record_count, 4);
+}
+
+bool HeaderPage::HasMagic(const char *data) {
+  return *reinterpret_cast<const uint32_t *>(data) == MAGIC;
+}
+
+uint32_t HeaderPage::ReadVersion(const char *data) {
+  return *reinterpret_cast<const uint32_t *>(data + 4);
+}
+
+size_t HeaderPage::ReadPageSize(const char *data) {
+  return static_cast<size_t>(*reinterpret_cast<const int *>(data + 8));
+}
+
+page_id_t HeaderPage::ReadFreeMapPageId(const char *data, size_t page_size) {
+  return *reinterpret_cast<const page_id_t *>(data + page_size - FREE_MAP_SIZE);
+}
+
+void HeaderPage::WriteFreeMapPageId(char *data, size_t page_size,
+                                    page_id_t page_id) {
+  memcpy(data + page_size - FREE_MAP_SIZE, &page_id, 4);
+}
+
+bool HeaderPage::UpgradeLegacy(const char *legacy, char *data) {
+  int record_count = *reinterpret_cast<const int *>(legacy);
+  if (record_count < 0 ||
+      RECORDS_OFFSET + record_count * RECORD_SIZE > PAGE_SIZE - FREE_MAP_SIZE) {
+    return false;
+  }
+  memset(data, 0, PAGE_SIZE);
+  Format(data, PAGE_SIZE);
+  memcpy(data + RECORDS_OFFSET, legacy + 4, record_count * RECORD_SIZE);
+  memcpy(data + 12, &record_count, 4);
+  return true;
 }
 
 int HeaderPage::FindRecord(const std::string &name) {
   int record_num = GetRecordCount();
 
   for (int i = 0; i < record_num; i++) {
-    char *raw_name = reinterpret_cast<char *>(GetData() + (4 + i * 36));
+    char *raw_name = reinterpret_cast<char *>(GetData() + (RECORDS_OFFSET + i * RECORD_SIZE));
     if (strcmp(raw_name, name.c_str()) == 0)
       return i;
   }
@@ -2,6 +2,7 @@
  * table_iterator.cpp
  */
 
+#include <algorithm>
 #include <cassert>
 
 #include "table/table_heap.h"
@@ -9,7 +10,8 @@
 namespace cmudb {
 
 TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn),
+      read_ahead_end_(0) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
   }
@@ -27,21 +29,20 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(
-      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr); // all pages are pinned
+  ReadPageGuard guard =
+      buffer_pool_manager->FetchPageRead(tuple_->rid_.GetPageId());
+  assert(guard.IsValid()); // all pages are pinned
+  auto cur_page = static_cast<TablePage *>(guard.GetPage());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  next_tuple_rid)) { // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(
-          buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      ReadAhead(cur_page->GetPageId(), cur_page->GetNextPageId());
+      // the next page is latched before this one is let go
+      guard = buffer_pool_manager->FetchPageRead(cur_page->GetNextPageId());
+      assert(guard.IsValid());
+      cur_page = static_cast<TablePage *>(guard.GetPage());
       if (cur_page->GetFirstTupleRid(next_tuple_rid))
         break;
     }
@@ -49,14 +50,30 @@ TableIterator &TableIterator::operator++() {
   tuple_->rid_ = next_tuple_rid;
 
   if (*this != table_heap_->end()) {
-    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
+    // copy the tuple from the page already held
+    cur_page->GetTuple(tuple_->rid_, *tuple_, txn_, table_heap_->lock_manager_);
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
   return *this;
 }
 
+/*
+ * The page chain of a heap built by appending is usually laid out in page id
+ * order. When the scan steps to the physically next page, ask the buffer pool
+ * to prefetch the following window, again each time half of it is consumed
+ */
+void TableIterator::ReadAhead(page_id_t cur_page_id, page_id_t next_page_id) {
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  page_id_t window =
+      static_cast<page_id_t>(buffer_pool_manager->GetReadAheadWindow());
+  if (window == 0 || next_page_id != cur_page_id + 1 ||
+      next_page_id + window / 2 < read_ahead_end_) {
+    return;
+  }
+  page_id_t from = std::max(next_page_id + 1, read_ahead_end_);
+  read_ahead_end_ = next_page_id + 1 + window;
+  buffer_pool_manager->PrefetchPages(from, read_ahead_end_ - from);
+}
+
 TableIterator TableIterator::operator++(int) {
   TableIterator clone(*this);
   ++(*this);
@@ -348,6 +348,127 @@ sqlite3_module VtableModule = {
     0,              /* xRollbackTo */
 };
 
+/* bustub_buffer_stats */
+namespace {
+// snapshot taken when the scan starts, one row per counter
+struct BufferStatsCursor {
+  sqlite3_vtab_cursor base;
+  std::vector<std::pair<std::string, uint64_t>> rows;
+  size_t pos;
+};
+} // namespace
+
+int BufferStatsConnect(sqlite3 *db, void *pAux, int argc,
+                       const char *const *argv, sqlite3_vtab **ppVtab,
+                       char **pzErr) {
+  int rc = sqlite3_declare_vtab(db, "CREATE TABLE X(name varchar, value bigint)");
+  if (rc != SQLITE_OK)
+    return rc;
+  *ppVtab = new sqlite3_vtab();
+  return SQLITE_OK;
+}
+
+int BufferStatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
+  // always a full scan of a handful of rows
+  pIdxInfo->estimatedCost = 10;
+  return SQLITE_OK;
+}
+
+int BufferStatsDisconnect(sqlite3_vtab *pVtab) {
+  delete pVtab;
+  return SQLITE_OK;
+}
+
+int BufferStatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
+  BufferStatsCursor *cursor = new BufferStatsCursor();
+  *ppCursor = &cursor->base;
+  return SQLITE_OK;
+}
+
+int BufferStatsClose(sqlite3_vtab_cursor *cur) {
+  delete reinterpret_cast<BufferStatsCursor *>(cur);
+  return SQLITE_OK;
+}
+
+int BufferStatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                      const char *idxStr, int argc, sqlite3_value **argv) {
+  BufferStatsCursor *cursor = reinterpret_cast<BufferStatsCursor *>(pVtabCursor);
+  cursor->rows.clear();
+  cursor->pos = 0;
+  if (storage_engine_ == nullptr)
+    return SQLITE_OK;
+  BufferPoolStats stats = storage_engine_->buffer_pool_manager_->GetStats();
+  cursor->rows = {{"hits", stats.hits},
+                  {"misses", stats.misses},
+                  {"evictions", stats.evictions},
+                  {"dirty_writebacks", stats.dirty_writebacks},
+                  {"foreground_writes", stats.foreground_writes},
+                  {"background_writes", stats.background_writes},
+                  {"prefetched_pages", stats.prefetched_pages},
+                  {"pin_waits", stats.pin_waits},
+                  {"latch_hold_ns", stats.latch_hold_ns},
+                  {"tier_hits", stats.tier_hits},
+                  {"tier_misses", stats.tier_misses},
+                  {"tier_bytes", stats.tier_bytes}};
+  WarmUpStats warm_up = storage_engine_->buffer_pool_manager_->GetWarmUpStats();
+  cursor->rows.emplace_back("warm_up_pages", warm_up.pages_loaded);
+  cursor->rows.emplace_back("warm_up_us", warm_up.elapsed.count());
+  cursor->rows.emplace_back("warm_up_done", warm_up.done ? 1 : 0);
+  return SQLITE_OK;
+}
+
+int BufferStatsNext(sqlite3_vtab_cursor *cur) {
+  reinterpret_cast<BufferStatsCursor *>(cur)->pos++;
+  return SQLITE_OK;
+}
+
+int BufferStatsEof(sqlite3_vtab_cursor *cur) {
+  BufferStatsCursor *cursor = reinterpret_cast<BufferStatsCursor *>(cur);
+  return cursor->pos >= cursor->rows.size();
+}
+
+int BufferStatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  BufferStatsCursor *cursor = reinterpret_cast<BufferStatsCursor *>(cur);
+  auto &row = cursor->rows[cursor->pos];
+  if (i == 0)
+    sqlite3_result_text(ctx, row.first.c_str(), -1, SQLITE_TRANSIENT);
+  else
+    sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(row.second));
+  return SQLITE_OK;
+}
+
+int BufferStatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
+  *pRowid = reinterpret_cast<BufferStatsCursor *>(cur)->pos;
+  return SQLITE_OK;
+}
+
+// no xCreate: the table is eponymous only and cannot be created or dropped
+sqlite3_module BufferStatsModule = {
+    0,                     /* iVersion */
+    0,                     /* xCreate */
+    BufferStatsConnect,    /* xConnect */
+    BufferStatsBestIndex,  /* xBestIndex */
+    BufferStatsDisconnect, /* xDisconnect */
+    0,                     /* xDestroy */
+    BufferStatsOpen,       /* xOpen - open a cursor */
+    BufferStatsClose,      /* xClose - close a cursor */
+    BufferStatsFilter,     /* xFilter - configure scan constraints */
+    BufferStatsNext,       /* xNext - advance a cursor */
+    BufferStatsEof,        /* xEof - check for end of scan */
+    BufferStatsColumn,     /* xColumn - read data */
+    BufferStatsRowid,      /* xRowid - read data */
+    0,                     /* xUpdate */
+    0,                     /* xBegin */
+    0,                     /* xSync */
+    0,                     /* xCommit */
+    0,                     /* xRollback */
+    0,                     /* xFindMethod */
+    0,                     /* xRename */
+    0,                     /* xSavepoint */
+    0,                     /* xRelease */
+    0,                     /* xRollbackTo */
+};
+
 #ifdef _WIN32
 __declspec(dllexport)
 #endif
@@ -369,9 +490,17 @@ __declspec(dllexport)
 
     assert(header_page_id == HEADER_PAGE_ID);
     storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
+  } else {
+    // reload what was resident at the last shutdown in the background
+    storage_engine_->buffer_pool_manager_->WarmUp(
+        storage_engine_->warm_up_file_name_);
   }
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
+  if (rc != SQLITE_OK)
+    return rc;
+  rc = sqlite3_create_module(db, "bustub_buffer_stats", &BufferStatsModule,
+                             nullptr);
   return rc;
 }
 
@@ -0,0 +1,128 @@
+/**
+ * arc_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/replacer_trace_util.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ARCReplacerTest, SampleTest) {
+  ARCReplacer<int> arc_replacer(4);
+
+  // 1 and 2 are accessed twice and move to T2, 3 and 4 stay in T1
+  arc_replacer.Insert(1);
+  arc_replacer.Insert(2);
+  arc_replacer.Insert(3);
+  arc_replacer.Insert(1);
+  arc_replacer.Insert(4);
+  arc_replacer.Insert(2);
+  EXPECT_EQ(4, arc_replacer.Size());
+
+  // target size of T1 is 0, so T1 is drained first in LRU order
+  int value;
+  arc_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+
+  // pinned values are skipped
+  EXPECT_EQ(true, arc_replacer.Erase(4));
+  EXPECT_EQ(false, arc_replacer.Erase(4));
+  arc_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(1, arc_replacer.Size());
+  arc_replacer.Insert(4);
+  arc_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  arc_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(false, arc_replacer.Victim(value));
+  EXPECT_EQ(0, arc_replacer.Size());
+}
+
+TEST(ARCReplacerTest, AdaptTest) {
+  ARCReplacer<int> arc_replacer(2);
+  int value;
+
+  // 1 is evicted from T1 and leaves a ghost in B1
+  arc_replacer.Insert(1);
+  arc_replacer.Insert(2);
+  arc_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(0, arc_replacer.GetTarget());
+
+  // a hit on the B1 ghost grows T1 and brings 1 back as frequent
+  arc_replacer.Insert(1);
+  EXPECT_EQ(1, arc_replacer.GetTarget());
+
+  // T1 is within its target, so T2 gives up 1 which becomes a B2 ghost
+  arc_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+
+  // T1 grows past its target and gives up 2
+  arc_replacer.Insert(3);
+  arc_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+
+  // a hit on the B2 ghost shrinks T1 again
+  arc_replacer.Insert(1);
+  EXPECT_EQ(0, arc_replacer.GetTarget());
+  arc_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+}
+
+TraceResult ReplayAndReport(const std::string &name,
+                            const std::vector<int> &trace,
+                            const std::set<int> &hot, size_t capacity,
+                            size_t num_pages) {
+  LRUReplacer<int> lru_replacer;
+  ClockReplacer<int> clock_replacer(num_pages,
+                                    [](const int &v) { return (size_t)v; });
+  LRUKReplacer<int> lru_k_replacer(2, capacity);
+  ARCReplacer<int> arc_replacer(capacity);
+  TraceResult lru = ReplayTrace(lru_replacer, capacity, trace, hot);
+  TraceResult clock = ReplayTrace(clock_replacer, capacity, trace, hot);
+  TraceResult lru_k = ReplayTrace(lru_k_replacer, capacity, trace, hot);
+  TraceResult arc = ReplayTrace(arc_replacer, capacity, trace, hot);
+
+  std::cout << name << " hit rate (index/overall): lru="
+            << lru.TrackedHitRate() << "/" << lru.HitRate()
+            << " clock=" << clock.TrackedHitRate() << "/" << clock.HitRate()
+            << " lru-2=" << lru_k.TrackedHitRate() << "/" << lru_k.HitRate()
+            << " arc=" << arc.TrackedHitRate() << "/" << arc.HitRate()
+            << std::endl;
+  EXPECT_GE(arc.HitRate(), lru.HitRate());
+  return arc;
+}
+
+// hit ratio report of every replacer on the same traces
+TEST(ARCReplacerTest, TraceReplayBenchmark) {
+  const int num_hot = 48;
+  const int num_cold = 2048;
+  const size_t capacity = 64;
+  std::set<int> hot;
+  for (int i = 0; i < num_hot; i++) {
+    hot.insert(i);
+  }
+
+  // index reuse distance above the pool size: no ghost survives the scan, ARC
+  // degrades to LRU here while LRU-2 keeps its retained history
+  ReplayAndReport("mixed", MixedScanTrace(num_hot, num_cold, 400, 32, 64), hot,
+                  capacity, num_hot + num_cold);
+
+  // scan bursts shorter than the pool: the hot set settles in T2 and the
+  // bursts only cycle through T1
+  TraceResult arc =
+      ReplayAndReport("shifting", ShiftingTrace(num_hot, num_cold, 400, 256, 48),
+                      hot, capacity, num_hot + num_cold);
+  EXPECT_GT(arc.TrackedHitRate(), 0.9);
+}
+
+} // namespace cmudb
@@ -0,0 +1,541 @@
+/**
+ * buffer_pool_manager_concurrent_test.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "logging/log_manager.h"
+
+namespace cmudb {
+
+// helper function to launch multiple threads
+template <typename... Args>
+void LaunchParallelTest(uint64_t num_threads, Args &&... args) {
+  std::vector<std::thread> thread_group;
+
+  // Launch a group of threads
+  for (uint64_t thread_itr = 0; thread_itr < num_threads; ++thread_itr) {
+    thread_group.push_back(std::thread(args..., thread_itr));
+  }
+
+  // Join the threads with the main thread
+  for (uint64_t thread_itr = 0; thread_itr < num_threads; ++thread_itr) {
+    thread_group[thread_itr].join();
+  }
+}
+
+// repeatedly fetch & unpin random resident pages
+void FetchHelper(BufferPoolManager *bpm, int num_pages, int num_ops,
+                 uint64_t thread_itr) {
+  std::mt19937 gen(thread_itr);
+  std::uniform_int_distribution<int> dist(0, num_pages - 1);
+  for (int i = 0; i < num_ops; i++) {
+    page_id_t page_id = dist(gen);
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+    bpm->UnpinPage(page_id, false);
+  }
+}
+
+// fill the pool with pages whose first bytes hold their own page id
+void PopulateHelper(BufferPoolManager *bpm, int num_pages) {
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+    bpm->UnpinPage(page_id, true);
+  }
+}
+
+TEST(BufferPoolManagerConcurrentTest, ShardedNewFetchTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 50;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // pool is much smaller than the data set, so evictions happen concurrently
+  BufferPoolManager *bpm = new BufferPoolManager(64, disk_manager, nullptr, 8);
+  EXPECT_EQ(8, bpm->GetNumInstances());
+
+  std::vector<std::vector<page_id_t>> page_ids(num_threads);
+  LaunchParallelTest(num_threads, [&](uint64_t thread_itr) {
+    for (int i = 0; i < pages_per_thread; i++) {
+      page_id_t page_id;
+      Page *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+      page_ids[thread_itr].push_back(page_id);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+  });
+  LaunchParallelTest(num_threads, [&](uint64_t thread_itr) {
+    for (page_id_t page_id : page_ids[thread_itr]) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  });
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// every thread owns a set of pages and keeps bumping a counter in them
+// through a pool much smaller than the data set, so that most victims are
+// dirty. Returns the number of foreground writes
+uint64_t DirtyEvictionRun(bool background_flush) {
+  const int num_threads = 4;
+  const int pages_per_thread = 32;
+  const int rounds = 20;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(32, disk_manager, nullptr, 4);
+  std::vector<std::vector<page_id_t>> page_ids(num_threads);
+  for (int t = 0; t < num_threads; t++) {
+    for (int i = 0; i < pages_per_thread; i++) {
+      page_id_t page_id;
+      Page *page = bpm->NewPage(page_id);
+      EXPECT_NE(nullptr, page);
+      memset(page->GetData(), 0, PAGE_SIZE);
+      page_ids[t].push_back(page_id);
+      bpm->UnpinPage(page_id, true);
+    }
+  }
+  if (background_flush) {
+    bpm->RunFlushThread(std::chrono::milliseconds(1));
+  }
+  LaunchParallelTest(num_threads, [&](uint64_t thread_itr) {
+    for (int r = 0; r < rounds; r++) {
+      for (page_id_t page_id : page_ids[thread_itr]) {
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        page->WLatch();
+        int *counter = reinterpret_cast<int *>(page->GetData());
+        EXPECT_EQ(r, *counter);
+        (*counter)++;
+        page->WUnlatch();
+        EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+        // time spent on query processing between page accesses
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }
+  });
+  bpm->StopFlushThread();
+  for (auto &ids : page_ids) {
+    for (page_id_t page_id : ids) {
+      Page *page = bpm->FetchPage(page_id);
+      EXPECT_NE(nullptr, page);
+      EXPECT_EQ(rounds, *reinterpret_cast<int *>(page->GetData()));
+      bpm->UnpinPage(page_id, false);
+    }
+  }
+  uint64_t foreground = bpm->GetForegroundWriteCount();
+  std::cout << (background_flush ? "with" : "without")
+            << " flusher: foreground writes=" << foreground
+            << " background writes=" << bpm->GetBackgroundWriteCount()
+            << std::endl;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  return foreground;
+}
+
+TEST(BufferPoolManagerConcurrentTest, BackgroundFlushTest) {
+  uint64_t without_flusher = DirtyEvictionRun(false);
+  uint64_t with_flusher = DirtyEvictionRun(true);
+  EXPECT_LT(with_flusher, without_flusher);
+}
+
+// measure FetchPage/UnpinPage throughput on a fully resident working set
+TEST(BufferPoolManagerConcurrentTest, FetchScalabilityBenchmark) {
+  const int num_pages = 256;
+  const int ops_per_thread = 20000;
+  for (size_t num_instances : {1, 16}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm =
+        new BufferPoolManager(num_pages, disk_manager, nullptr, num_instances);
+    PopulateHelper(bpm, num_pages);
+    for (uint64_t num_threads : {1, 2, 4, 8, 16}) {
+      auto start = std::chrono::steady_clock::now();
+      LaunchParallelTest(num_threads, FetchHelper, bpm, num_pages,
+                         ops_per_thread);
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      double ops = static_cast<double>(num_threads * ops_per_thread);
+      std::cout << "instances=" << num_instances
+                << " threads=" << num_threads
+                << " fetch+unpin/s=" << static_cast<uint64_t>(ops / elapsed.count())
+                << std::endl;
+    }
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+// fetchers of the same cold page share one read, everybody sees its data
+TEST(BufferPoolManagerConcurrentTest, SharedColdReadTest) {
+  const int num_threads = 8;
+  const int num_pages = 64;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(16, disk_manager);
+  PopulateHelper(bpm, num_pages);
+  for (int round = 0; round < 20; round++) {
+    LaunchParallelTest(num_threads, [&](uint64_t thread_itr) {
+      for (int i = 0; i < num_pages; i++) {
+        // every thread walks the same pages, most of them are cold
+        page_id_t page_id = (i + round * 7) % num_pages;
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          // all 16 frames pinned by the other threads
+          continue;
+        }
+        page->RLatch();
+        EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+        page->RUnlatch();
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// more pages than frames: misses keep reusing frames while other threads
+// fast pin the same pages, a fetched page always holds its data
+TEST(BufferPoolManagerConcurrentTest, FastPinMissTest) {
+  const int num_threads = 8;
+  const int num_pages = 12;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(8, disk_manager);
+  PopulateHelper(bpm, num_pages);
+  LaunchParallelTest(num_threads, [&](uint64_t thread_itr) {
+    std::mt19937 gen(thread_itr);
+    std::uniform_int_distribution<int> dist(0, num_pages - 1);
+    for (int i = 0; i < 20000; i++) {
+      page_id_t page_id = dist(gen);
+      Page *page = bpm->FetchPage(page_id);
+      if (page == nullptr) {
+        // every frame pinned by the other threads
+        continue;
+      }
+      page->RLatch();
+      EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+      page->RUnlatch();
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  });
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// a checkpoint never writes a page that a writer is halfway through
+TEST(BufferPoolManagerConcurrentTest, FlushAllPagesLatchTest) {
+  const int num_pages = 8;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(16, disk_manager, nullptr, 2);
+  PopulateHelper(bpm, num_pages);
+  const size_t page_size = bpm->GetPageSize();
+  for (page_id_t page_id = 1; page_id < num_pages; page_id++) {
+    WritePageGuard guard = bpm->FetchPageWrite(page_id);
+    memset(guard.GetData(), 0, page_size);
+    guard.MarkDirty();
+  }
+  std::atomic<bool> done(false);
+  std::thread writer([&] {
+    for (char c = 0; !done; c++) {
+      // page 0 is the header page, leave it alone
+      for (page_id_t page_id = 1; page_id < num_pages; page_id++) {
+        WritePageGuard guard = bpm->FetchPageWrite(page_id);
+        ASSERT_TRUE(guard.IsValid());
+        memset(guard.GetData(), c, page_size);
+        guard.MarkDirty();
+      }
+    }
+  });
+  std::vector<char> data(page_size);
+  for (int round = 0; round < 200; round++) {
+    bpm->FlushAllPages();
+    for (page_id_t page_id = 1; page_id < num_pages; page_id++) {
+      disk_manager->ReadPage(page_id, data.data());
+      for (size_t i = 1; i < page_size; i++) {
+        if (data[i] != data[0]) {
+          ADD_FAILURE() << "torn page " << page_id << " in round " << round;
+          break;
+        }
+      }
+    }
+  }
+  done = true;
+  writer.join();
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// the flush thread picks a page, then a writer logs past the persistent LSN
+// before the flusher gets the page latch: the page must stay in memory
+TEST(BufferPoolManagerConcurrentTest, FlushThreadWalTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  LogManager *log_manager = new LogManager(disk_manager);
+  ENABLE_LOGGING = true;
+  log_manager->SetPersistentLSN(10);
+  BufferPoolManager *bpm = new BufferPoolManager(16, disk_manager, log_manager);
+  page_id_t page_id;
+  // page 0 is the header page
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  bpm->UnpinPage(page_id, true);
+  Page *page = bpm->NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData() + 8, 16, "before");
+  page->SetLSN(5);
+  bpm->UnpinPage(page_id, true);
+  bpm->FlushAllPages();
+
+  page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData() + 8, 16, "after");
+  bpm->UnpinPage(page_id, true);
+  // dirty and logged: the flush thread picks the page, then waits for us
+  page->WLatch();
+  bpm->RunFlushThread(std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  page->SetLSN(20);
+  page->WUnlatch();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  bpm->StopFlushThread();
+
+  std::vector<char> data(bpm->GetPageSize());
+  disk_manager->ReadPage(page_id, data.data());
+  EXPECT_EQ(0, strcmp("before", data.data() + 8));
+  // still dirty: once the log catches up the page goes out
+  log_manager->SetPersistentLSN(20);
+  bpm->FlushAllPages();
+  disk_manager->ReadPage(page_id, data.data());
+  EXPECT_EQ(0, strcmp("after", data.data() + 8));
+
+  ENABLE_LOGGING = false;
+  delete bpm;
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// hits on a resident hot set while another thread keeps missing on cold
+// pages of the same instance
+TEST(BufferPoolManagerConcurrentTest, MixedHotColdBenchmark) {
+  const int num_hot = 32;
+  const int num_cold = 512;
+  const int hot_threads = 4;
+  const int ops_per_thread = 20000;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(64, disk_manager);
+  // cold pages first so that the hot ones end up resident
+  PopulateHelper(bpm, num_cold + num_hot);
+
+  for (bool with_cold : {false, true}) {
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> cold_reads(0);
+    std::thread cold_thread;
+    if (with_cold) {
+      cold_thread = std::thread([&] {
+        for (int i = 0; !done; i = (i + 1) % num_cold) {
+          Page *page = bpm->FetchPage(i);
+          ASSERT_NE(nullptr, page);
+          EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+          bpm->UnpinPage(i, false);
+          cold_reads++;
+        }
+      });
+    }
+    auto start = std::chrono::steady_clock::now();
+    LaunchParallelTest(hot_threads, [&](uint64_t thread_itr) {
+      std::mt19937 gen(thread_itr);
+      std::uniform_int_distribution<int> dist(num_cold, num_cold + num_hot - 1);
+      for (int i = 0; i < ops_per_thread; i++) {
+        page_id_t page_id = dist(gen);
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    done = true;
+    if (with_cold) {
+      cold_thread.join();
+    }
+    std::cout << (with_cold ? "with" : "without") << " cold reader: hot fetch/s="
+              << static_cast<uint64_t>(hot_threads * ops_per_thread /
+                                       elapsed.count())
+              << " cold reads=" << cold_reads << std::endl;
+  }
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// every thread fetches and unpins the same page, the way each B+ tree
+// operation starts at the root. While the page stays pinned the pool latch
+// is never taken
+TEST(BufferPoolManagerConcurrentTest, RootPageHammerBenchmark) {
+  const int num_threads = 8;
+  const int ops_per_thread = 200000;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(16, disk_manager);
+  PopulateHelper(bpm, 16);
+
+  // the tree holds the root pinned, e.g. by a long running scan
+  Page *root = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, root);
+  BufferPoolStats before = bpm->GetStats();
+  auto start = std::chrono::steady_clock::now();
+  LaunchParallelTest(num_threads, [bpm, root](uint64_t) {
+    for (int i = 0; i < ops_per_thread; i++) {
+      Page *page = bpm->FetchPage(0);
+      ASSERT_EQ(root, page);
+      bpm->UnpinPage(0, false);
+    }
+  });
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  BufferPoolStats after = bpm->GetStats();
+  std::cout << "root fetch+unpin/s="
+            << static_cast<uint64_t>(num_threads * ops_per_thread /
+                                     elapsed.count())
+            << std::endl;
+  EXPECT_EQ(static_cast<uint64_t>(num_threads * ops_per_thread),
+            after.hits - before.hits);
+  EXPECT_EQ(before.latch_hold_ns, after.latch_hold_ns);
+  EXPECT_EQ(1, root->GetPinCount());
+
+  // the last unpin goes through the latch and makes the page evictable
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(0, root->GetPinCount());
+  EXPECT_EQ(false, bpm->UnpinPage(0, false));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// threads create pages one by one and in batches while others fetch; every
+// page id must be handed out once and map to its own frame
+TEST(BufferPoolManagerConcurrentTest, ConcurrentNewPageTest) {
+  const int num_threads = 8;
+  const int rounds = 50;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(64, disk_manager, nullptr, 4);
+  std::vector<std::vector<page_id_t>> created(num_threads);
+
+  LaunchParallelTest(num_threads, [bpm, &created](uint64_t thread_itr) {
+    for (int r = 0; r < rounds; r++) {
+      std::vector<Page *> pages(1);
+      page_id_t first_page_id;
+      if (r % 2 == 0) {
+        pages[0] = bpm->NewPage(first_page_id);
+        ASSERT_NE(nullptr, pages[0]);
+      } else {
+        ASSERT_EQ(true, bpm->NewPages(4, first_page_id, pages));
+      }
+      for (size_t i = 0; i < pages.size(); i++) {
+        page_id_t page_id = first_page_id + static_cast<page_id_t>(i);
+        ASSERT_EQ(page_id, pages[i]->GetPageId());
+        memcpy(pages[i]->GetData(), &page_id, sizeof(page_id_t));
+        created[thread_itr].push_back(page_id);
+        bpm->UnpinPage(page_id, true);
+      }
+      // fetch a page of another thread's making
+      Page *page = bpm->FetchPage(first_page_id / 2);
+      if (page != nullptr) {
+        bpm->UnpinPage(first_page_id / 2, false);
+      }
+    }
+  });
+
+  std::vector<bool> seen(disk_manager->GetNextPageId(), false);
+  size_t total = 0;
+  for (auto &ids : created) {
+    for (page_id_t page_id : ids) {
+      ASSERT_LT(page_id, static_cast<page_id_t>(seen.size()));
+      EXPECT_EQ(false, seen[page_id]);
+      seen[page_id] = true;
+      total++;
+    }
+  }
+  EXPECT_EQ(static_cast<size_t>(num_threads * rounds / 2 * 5), total);
+  for (size_t page_id = 0; page_id < seen.size(); page_id++) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(static_cast<page_id_t>(page_id),
+              *reinterpret_cast<page_id_t *>(page->GetData()));
+    bpm->UnpinPage(page_id, false);
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// bulk load 4096 pages one NewPage at a time and in batches of 64
+TEST(BufferPoolManagerConcurrentTest, BulkLoadBenchmark) {
+  const int num_pages = 4096;
+  const int batch = 64;
+  for (bool batched : {false, true}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm =
+        new BufferPoolManager(num_pages, disk_manager, nullptr, 4);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Page *> pages;
+    page_id_t first_page_id;
+    for (int i = 0; i < num_pages; i += batch) {
+      if (batched) {
+        ASSERT_EQ(true, bpm->NewPages(batch, first_page_id, pages));
+      } else {
+        pages.clear();
+        for (int k = 0; k < batch; k++) {
+          page_id_t page_id;
+          pages.push_back(bpm->NewPage(page_id));
+          ASSERT_NE(nullptr, pages.back());
+        }
+      }
+      for (Page *page : pages) {
+        bpm->UnpinPage(page->GetPageId(), true);
+      }
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << (batched ? "NewPages: " : "NewPage: ") << num_pages
+              << " pages in " << elapsed.count() << " us, latch held "
+              << bpm->GetStats().latch_hold_ns / 1000 << " us" << std::endl;
+    delete bpm;
+    delete disk_manager;
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
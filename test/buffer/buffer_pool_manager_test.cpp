@@ -2,10 +2,15 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <chrono>
 #include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
+#include "logging/log_manager.h"
 
 namespace cmudb {
 
@@ -48,4 +53,416 @@ TEST(BufferPoolManagerTest, SampleTest) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, ClockReplacerTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager, nullptr, 1, ReplacerType::CLOCK);
+
+  auto page_zero = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, temp_page_id);
+  strcpy(page_zero->GetData(), "Hello");
+
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  // all the pages are pinned, the buffer pool is full
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  // unpin the first five pages, set as dirty
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  // four of them get evicted, dirty ones are written back
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  page_zero = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, ARCReplacerTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager, nullptr, 1, ReplacerType::ARC);
+
+  auto page_zero = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, temp_page_id);
+  strcpy(page_zero->GetData(), "Hello");
+
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  // page 0 is referenced twice and survives the following burst of new pages
+  EXPECT_EQ(page_zero, bpm.FetchPage(0));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  // deleted pages hand their frames back, their entries must not leak
+  EXPECT_EQ(true, bpm.DeletePage(1));
+  EXPECT_EQ(true, bpm.DeletePage(2));
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  EXPECT_EQ(page_zero, bpm.FetchPage(0));
+  EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, FlushThreadTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager);
+
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // a later clean unpin keeps the page dirty
+  ASSERT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+  // the flusher cleans every unpinned frame, evictions no longer write
+  bpm.RunFlushThread(std::chrono::milliseconds(1));
+  for (int i = 0; i < 1000 && bpm.GetBackgroundWriteCount() < 10; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bpm.StopFlushThread();
+  EXPECT_EQ(10, bpm.GetBackgroundWriteCount());
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  EXPECT_EQ(0, bpm.GetForegroundWriteCount());
+
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, NewPagesTest) {
+  page_id_t first_page_id;
+  std::vector<Page *> pages;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager, nullptr, 2);
+  ASSERT_EQ(true, bpm.NewPages(6, first_page_id, pages));
+  EXPECT_EQ(0, first_page_id);
+  ASSERT_EQ(6, pages.size());
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(i, pages[i]->GetPageId());
+    EXPECT_EQ(1, pages[i]->GetPinCount());
+    snprintf(pages[i]->GetData(), PAGE_SIZE, "page %d", i);
+  }
+
+  // 4 frames left, 5 pages cannot be held pinned: nothing is created
+  EXPECT_EQ(false, bpm.NewPages(5, first_page_id, pages));
+  EXPECT_EQ(0, pages.size());
+  // the ids of the failed call were given back
+  ASSERT_EQ(true, bpm.NewPages(4, first_page_id, pages));
+  EXPECT_EQ(6, first_page_id);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(first_page_id + i, false));
+  }
+
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  ASSERT_EQ(true, bpm.NewPages(10, first_page_id, pages));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(first_page_id + i, false));
+  }
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 6; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  BufferPoolStats stats = bpm.GetStats();
+  EXPECT_EQ(0, stats.hits + stats.misses + stats.evictions);
+
+  // hit on page 0, so page 1 is the LRU victim of the next new page
+  ASSERT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  // reading page 1 back is a miss and evicts dirty page 2
+  ASSERT_NE(nullptr, bpm.FetchPage(1));
+  EXPECT_EQ(true, bpm.UnpinPage(1, false));
+
+  stats = bpm.GetStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(2, stats.evictions);
+  EXPECT_EQ(2, stats.dirty_writebacks);
+  EXPECT_EQ(2, stats.foreground_writes);
+  EXPECT_EQ(0, stats.pin_waits);
+  EXPECT_GT(stats.latch_hold_ns, 0);
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const int num_pages = 20;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(num_pages, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+
+  bpm = new BufferPoolManager(10, disk_manager);
+  // at most half the pool is queued
+  bpm->PrefetchPages(0, num_pages);
+  for (int i = 0; i < 1000 && bpm->GetPrefetchCount() < 5; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(5, bpm->GetPrefetchCount());
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(0, stats.hits + stats.misses);
+
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 5; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  stats = bpm->GetStats();
+  EXPECT_EQ(5, stats.hits);
+  EXPECT_EQ(0, stats.misses);
+  delete bpm;
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  const int num_pages = 20;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  // pages 10..19 are resident, use some of them again, 13 last
+  for (page_id_t page_id : {17, 11, 15, 13}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  // a pinned page counts as the most recent
+  ASSERT_NE(nullptr, bpm->FetchPage(19));
+  EXPECT_EQ(true, bpm->DumpResidentPages("test.warm"));
+  EXPECT_EQ(true, bpm->UnpinPage(19, false));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  std::vector<page_id_t> dump(10);
+  FILE *file = fopen("test.warm", "rb");
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(10, fread(dump.data(), sizeof(page_id_t), 10, file));
+  fclose(file);
+  EXPECT_EQ((std::vector<page_id_t>{19, 13, 15, 11, 17}),
+            std::vector<page_id_t>(dump.begin(), dump.begin() + 5));
+
+  // a smaller pool loads the most recent half
+  bpm = new BufferPoolManager(5, disk_manager);
+  EXPECT_EQ(false, bpm->WarmUp("missing.warm"));
+  EXPECT_EQ(true, bpm->WarmUp("test.warm"));
+  bpm->WaitForWarmUp();
+  WarmUpStats warm_up = bpm->GetWarmUpStats();
+  EXPECT_EQ(true, warm_up.done);
+  EXPECT_EQ(5, warm_up.pages_loaded);
+  char expected[PAGE_SIZE];
+  for (page_id_t page_id : {11, 13, 15, 17, 19}) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(5, stats.hits);
+  EXPECT_EQ(0, stats.misses);
+  delete bpm;
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.warm");
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  const int num_pages = 40;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager, nullptr, 2);
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  // a pinned dirty page is written as well
+  Page *pinned = bpm->FetchPage(7);
+  ASSERT_NE(nullptr, pinned);
+
+  FlushStats stats = bpm->FlushAllPages();
+  EXPECT_EQ(num_pages, stats.pages_flushed);
+  EXPECT_EQ(true, stats.synced);
+  EXPECT_EQ(num_pages, bpm->GetForegroundWriteCount());
+  EXPECT_EQ(0, bpm->FlushAllPages().pages_flushed);
+  EXPECT_EQ(true, bpm->UnpinPage(7, false));
+  delete bpm;
+
+  // everything is on disk, a fresh pool reads it back
+  bpm = new BufferPoolManager(10, disk_manager);
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  delete bpm;
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// flush a large dirty pool page by page and as one checkpoint
+// a deleted page is only freed by a checkpoint that wrote every dirty page
+TEST(BufferPoolManagerTest, DeletePageTest) {
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  LogManager *log_manager = new LogManager(disk_manager);
+  ENABLE_LOGGING = true;
+  log_manager->SetPersistentLSN(10);
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager, log_manager);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  bpm->FlushAllPages();
+  // page 1 still points to page 2 on disk: its change is not logged yet
+  Page *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  page->SetLSN(20);
+  EXPECT_EQ(true, bpm->UnpinPage(1, true));
+  EXPECT_EQ(true, bpm->DeletePage(2));
+  EXPECT_EQ(0u, disk_manager->GetFreePageCount());
+  bpm->FlushAllPages();
+  EXPECT_EQ(0u, disk_manager->GetFreePageCount());
+
+  // page 2 was queued again; the first page freed becomes a free map page
+  log_manager->SetPersistentLSN(20);
+  EXPECT_EQ(true, bpm->DeletePage(1));
+  bpm->FlushAllPages();
+  EXPECT_EQ(1u, disk_manager->GetFreePageCount());
+  ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+  EXPECT_EQ(1, temp_page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+
+  ENABLE_LOGGING = false;
+  delete bpm;
+  delete log_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesBenchmark) {
+  const int num_pages = 4096;
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(num_pages, disk_manager, nullptr, 4);
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < num_pages; ++i) {
+      Page *page = round == 0 ? bpm.NewPage(temp_page_id) : bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d round %d", i, round);
+      EXPECT_EQ(true, bpm.UnpinPage(page->GetPageId(), true));
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t flushed = 0;
+    if (round == 0) {
+      for (int i = 0; i < num_pages; ++i) {
+        flushed += bpm.FlushPage(i) ? 1 : 0;
+      }
+    } else {
+      flushed = bpm.FlushAllPages().pages_flushed;
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    std::cout << (round == 0 ? "FlushPage loop: " : "FlushAllPages: ")
+              << flushed << " pages in " << ms << " ms" << std::endl;
+    EXPECT_EQ(num_pages, flushed);
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
 } // namespace cmudb
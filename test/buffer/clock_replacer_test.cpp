@@ -0,0 +1,87 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer<int> clock_replacer(7, [](const int &v) { return (size_t)v; });
+
+  // push element into replacer
+  clock_replacer.Insert(1);
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(3);
+  clock_replacer.Insert(4);
+  clock_replacer.Insert(5);
+  clock_replacer.Insert(6);
+  clock_replacer.Insert(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // first sweep clears every reference bit, then frames go in clock order
+  int value;
+  clock_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+
+  // a referenced frame gets a second chance
+  clock_replacer.Insert(3);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, clock_replacer.Erase(4));
+  EXPECT_EQ(true, clock_replacer.Erase(6));
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  // pop element from replacer after removal
+  clock_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+// hit path of the buffer pool: Erase on pin, Insert on unpin
+template <typename ReplacerT>
+double HitPathNanos(ReplacerT &replacer, int num_frames, int rounds) {
+  for (int i = 0; i < num_frames; i++) {
+    replacer.Insert(i);
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < num_frames; i++) {
+      int frame = (i * 7 + r) % num_frames;
+      replacer.Erase(frame);
+      replacer.Insert(frame);
+    }
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / (static_cast<double>(rounds) * num_frames);
+}
+
+TEST(ClockReplacerTest, HitPathBenchmark) {
+  const int num_frames = 1024;
+  const int rounds = 200;
+  LRUReplacer<int> lru_replacer;
+  ClockReplacer<int> clock_replacer(num_frames,
+                                    [](const int &v) { return (size_t)v; });
+  double lru_ns = HitPathNanos(lru_replacer, num_frames, rounds);
+  double clock_ns = HitPathNanos(clock_replacer, num_frames, rounds);
+  std::cout << "erase+insert ns/op: lru=" << lru_ns << " clock=" << clock_ns
+            << std::endl;
+  EXPECT_EQ(num_frames, lru_replacer.Size());
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+}
+
+} // namespace cmudb
@@ -0,0 +1,133 @@
+/**
+ * compressed_tier_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/compressed_tier.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(CompressedTierTest, SampleTest) {
+  const size_t page_size = 512;
+  std::vector<char> page(page_size, 0);
+  std::vector<char> out(page_size);
+  CompressedTier tier(100, page_size);
+  for (page_id_t page_id = 0; page_id < 10; page_id++) {
+    snprintf(page.data(), page_size, "page %d", page_id);
+    tier.Insert(page_id, page.data());
+  }
+  // the budget holds only the most recent pages
+  EXPECT_LE(tier.GetUsedBytes(), 100);
+  EXPECT_GT(tier.GetEvictions(), 0);
+  EXPECT_EQ(false, tier.Take(0, out.data()));
+  EXPECT_EQ(true, tier.Take(9, out.data()));
+  EXPECT_EQ(0, strcmp(out.data(), "page 9"));
+  // taking a page removes it
+  EXPECT_EQ(false, tier.Take(9, out.data()));
+  EXPECT_EQ(1, tier.GetHits());
+  EXPECT_EQ(2, tier.GetMisses());
+
+  tier.Erase(8);
+  EXPECT_EQ(false, tier.Take(8, out.data()));
+
+  // incompressible pages are not stored
+  for (size_t i = 0; i < page_size; i++) {
+    page[i] = static_cast<char>(i * 131 + (i >> 3) * 17);
+  }
+  size_t size = tier.GetSize();
+  tier.Insert(100, page.data());
+  EXPECT_GE(size, tier.GetSize());
+}
+
+TEST(CompressedTierTest, BufferPoolTest) {
+  const int num_pages = 20;
+  page_id_t temp_page_id;
+  BUFFER_POOL_COMPRESSED_TIER_BUDGET = 1 << 20;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(5, disk_manager);
+  BUFFER_POOL_COMPRESSED_TIER_BUDGET = 0;
+  ASSERT_NE(nullptr, bpm->GetCompressedTier());
+  for (int i = 0; i < num_pages; i++) {
+    Page *page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+  }
+  // everything but the 5 resident pages went to the tier
+  EXPECT_EQ(num_pages - 5, bpm->GetCompressedTier()->GetSize());
+
+  char expected[PAGE_SIZE];
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "page %d", i);
+      EXPECT_EQ(0, strcmp(page->GetData(), expected));
+      EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    }
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(stats.misses, stats.tier_hits);
+  EXPECT_EQ(0, stats.tier_misses);
+
+  // a deleted page must not come back from the tier
+  EXPECT_EQ(true, bpm->DeletePage(0));
+  EXPECT_EQ(false, bpm->GetCompressedTier()->Take(0, expected));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// working set 1.5 times the pool: cycle through it with and without a tier
+TEST(CompressedTierTest, WorkingSetBenchmark) {
+  const int pool_size = 256;
+  const int num_pages = pool_size * 3 / 2;
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
+  {
+    BufferPoolManager bpm(num_pages, disk_manager);
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      // a half full page, like a B+ tree node after a split
+      for (int k = 0; k < 64; k++) {
+        snprintf(page->GetData() + k * 32, 32, "key %d.%d", i, k);
+      }
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+    }
+    bpm.FlushAllPages();
+  }
+  for (size_t budget : {size_t(0), size_t(4) << 20}) {
+    BUFFER_POOL_COMPRESSED_TIER_BUDGET = budget;
+    BufferPoolManager bpm(pool_size, disk_manager);
+    BUFFER_POOL_COMPRESSED_TIER_BUDGET = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 20; round++) {
+      for (int i = 0; i < num_pages; i++) {
+        ASSERT_NE(nullptr, bpm.FetchPage(i));
+        bpm.UnpinPage(i, false);
+      }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    BufferPoolStats stats = bpm.GetStats();
+    std::cout << (budget == 0 ? "without tier: " : "with tier: ")
+              << elapsed.count() << " us, " << stats.misses << " misses, "
+              << stats.tier_hits << " tier hits, " << stats.tier_bytes
+              << " tier bytes" << std::endl;
+  }
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
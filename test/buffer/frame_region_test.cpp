@@ -0,0 +1,158 @@
+/**
+ * frame_region_test.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <random>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_region.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(FrameRegionTest, LayoutTest) {
+  FrameRegion region(100, PAGE_SIZE, false, -1);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(region.GetFrame(0)) % 4096);
+  EXPECT_GE(region.GetLength(), 100 * PAGE_SIZE);
+  EXPECT_EQ(region.GetFrame(0) + 99 * PAGE_SIZE, region.GetFrame(99));
+  // anonymous memory starts zeroed
+  for (size_t i = 0; i < 100 * PAGE_SIZE; ++i) {
+    ASSERT_EQ(0, region.GetFrame(0)[i]);
+  }
+  region.GetFrame(99)[PAGE_SIZE - 1] = 1;
+
+  FrameRegion huge(100, PAGE_SIZE, true, 0);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(huge.GetFrame(0)) % (2 << 20));
+  std::cout << "huge pages: " << huge.IsHugePageBacked()
+            << ", numa bound: " << huge.IsNumaBound() << std::endl;
+  huge.GetFrame(99)[PAGE_SIZE - 1] = 1;
+}
+
+TEST(FrameRegionTest, BufferPoolTest) {
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BUFFER_POOL_HUGE_PAGES = true;
+  BufferPoolManager bpm(64, disk_manager, nullptr, 4);
+  BUFFER_POOL_HUGE_PAGES = false;
+
+  // frames of every instance come from the one region
+  const FrameRegion &region = bpm.GetFrameRegion();
+  for (int i = 0; i < 64; ++i) {
+    Page *page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_GE(page->GetData(), region.GetFrame(0));
+    EXPECT_LE(page->GetData(), region.GetFrame(63));
+    EXPECT_EQ(0, (page->GetData() - region.GetFrame(0)) % PAGE_SIZE);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // evict everything and read it back
+  for (int i = 0; i < 64; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 64; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+namespace {
+// dTLB read misses of this thread, -1 if the counter is not available
+class DTLBCounter {
+public:
+  DTLBCounter() {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+  ~DTLBCounter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+  void Start() {
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+  long long Stop() {
+    long long count = -1;
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+        count = -1;
+      }
+    }
+    return count;
+  }
+
+private:
+  int fd_;
+};
+} // namespace
+
+// touch one word of every frame of a 64MB pool in random order, the way a
+// pool serving random lookups does, with normal and with huge pages
+TEST(FrameRegionTest, TLBBenchmark) {
+  const size_t num_frames = (64 << 20) / PAGE_SIZE;
+  const int rounds = 4;
+  std::vector<size_t> order(num_frames);
+  for (size_t i = 0; i < num_frames; ++i) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+  for (bool huge : {false, true}) {
+    FrameRegion region(num_frames, PAGE_SIZE, huge, -1);
+    for (size_t i = 0; i < num_frames; ++i) {
+      region.GetFrame(i)[0] = static_cast<char>(i);
+    }
+    DTLBCounter counter;
+    uint64_t sum = 0;
+    counter.Start();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+      for (size_t i : order) {
+        sum += static_cast<unsigned char>(region.GetFrame(i)[0]);
+      }
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    long long misses = counter.Stop();
+    std::cout << (huge ? "huge pages" : "4KB pages") << " (backed "
+              << region.IsHugePageBacked() << "): "
+              << rounds * num_frames / ms / 1000 << " M frames/s, dTLB misses "
+              << (misses < 0 ? std::string("n/a") : std::to_string(misses))
+              << " (sum " << sum << ")" << std::endl;
+  }
+}
+
+} // namespace cmudb
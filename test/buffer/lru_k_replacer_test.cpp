@@ -0,0 +1,168 @@
+/**
+ * lru_k_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <iostream>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/replacer_trace_util.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 0);
+
+  // 1 and 2 are accessed twice, the rest only once
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(5);
+  lru_k_replacer.Insert(2);
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // values seen once go first, oldest first
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // pinning keeps history, unpin adds one more access
+  EXPECT_EQ(true, lru_k_replacer.Erase(5));
+  EXPECT_EQ(false, lru_k_replacer.Erase(5));
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  lru_k_replacer.Insert(5);
+
+  // every value has two accesses now, oldest 2nd most recent access goes
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+
+  // history of a victim is forgotten
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(6);
+  lru_k_replacer.Insert(6);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+}
+
+TEST(LRUKReplacerTest, RetainedHistoryTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 1);
+  int value;
+
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+
+  // 1 comes back and remembers its first access, 2 is seen for the first time
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+
+  // only one evicted history is retained: 2 is dropped once 3 is evicted
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+}
+
+// point lookups on a small set of index pages interleaved with a large
+// sequential table scan; report how many index lookups stay in memory
+TEST(LRUKReplacerTest, MixedScanBenchmark) {
+  const int num_hot = 32;
+  const int num_cold = 4096;
+  const size_t capacity = 64;
+  std::vector<int> trace = MixedScanTrace(num_hot, num_cold, 400, 32, 64);
+  std::set<int> hot;
+  for (int i = 0; i < num_hot; i++) {
+    hot.insert(i);
+  }
+
+  LRUReplacer<int> lru_replacer;
+  ClockReplacer<int> clock_replacer(num_hot + num_cold,
+                                    [](const int &v) { return (size_t)v; });
+  LRUKReplacer<int> lru_k_replacer(2, capacity);
+  TraceResult lru = ReplayTrace(lru_replacer, capacity, trace, hot);
+  TraceResult clock = ReplayTrace(clock_replacer, capacity, trace, hot);
+  TraceResult lru_k = ReplayTrace(lru_k_replacer, capacity, trace, hot);
+
+  std::cout << "index page hit rate: lru=" << lru.TrackedHitRate()
+            << " clock=" << clock.TrackedHitRate()
+            << " lru-2=" << lru_k.TrackedHitRate() << std::endl;
+  std::cout << "overall hit rate: lru=" << lru.HitRate()
+            << " clock=" << clock.HitRate() << " lru-2=" << lru_k.HitRate()
+            << std::endl;
+  EXPECT_GT(lru_k.TrackedHitRate(), lru.TrackedHitRate());
+}
+
+// pages that are created and deleted over and over must not leave their
+// history behind
+TEST(LRUKReplacerTest, DeletedPageTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(4, disk_manager);
+  LRUKReplacer<Page *> lru_k_replacer(2, 0);
+  page_id_t page_id;
+  Page *hot = bpm.NewPage(page_id);
+  lru_k_replacer.Insert(hot);
+  for (int i = 0; i < 10000; ++i) {
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    lru_k_replacer.Insert(page);
+    lru_k_replacer.Insert(page);
+    EXPECT_EQ(true, lru_k_replacer.Erase(page));
+    bpm.UnpinPage(page_id, false);
+    EXPECT_EQ(true, bpm.DeletePage(page_id));
+  }
+  EXPECT_LE(lru_k_replacer.GetHistorySize(), 130);
+  EXPECT_EQ(1, lru_k_replacer.Size());
+  Page *victim;
+  EXPECT_EQ(true, lru_k_replacer.Victim(victim));
+  EXPECT_EQ(hot, victim);
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(LRUKReplacerTest, PrefetchTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 0);
+  // read ahead, then fetched (pinned) and unpinned once
+  lru_k_replacer.InsertPrefetched(1);
+  EXPECT_EQ(1, lru_k_replacer.Size());
+  EXPECT_EQ(true, lru_k_replacer.Erase(1));
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  // the prefetch was no access: 1 was used once and is older than 3
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+
+  // prefetching a value with history adds no access either
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(5);
+  EXPECT_EQ(true, lru_k_replacer.Erase(4));
+  lru_k_replacer.InsertPrefetched(4);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+}
+
+} // namespace cmudb
@@ -0,0 +1,127 @@
+/**
+ * page_guard_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(PageGuardTest, ScopeTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(5, disk_manager);
+  page_id_t page_id;
+  Page *page;
+  {
+    WritePageGuard guard = bpm.NewPageGuarded(page_id);
+    ASSERT_EQ(true, guard.IsValid());
+    EXPECT_EQ(page_id, guard.GetPageId());
+    EXPECT_EQ(true, guard.IsExclusive());
+    // a new page is written back even if left untouched
+    EXPECT_EQ(true, guard.IsDirty());
+    page = guard.GetPage();
+    EXPECT_EQ(1, page->GetPinCount());
+    strcpy(guard.GetData(), "Hello");
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  {
+    ReadPageGuard guard1 = bpm.FetchPageRead(page_id);
+    ReadPageGuard guard2 = bpm.FetchPageRead(page_id);
+    EXPECT_EQ(false, guard1.IsExclusive());
+    EXPECT_EQ(false, guard1.IsDirty());
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_EQ(0, strcmp(guard2.GetData(), "Hello"));
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  {
+    // the read latches are gone, a writer gets in
+    WritePageGuard guard = bpm.FetchPageWrite(page_id);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(false, guard.IsDirty());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(PageGuardTest, MoveTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(5, disk_manager);
+  page_id_t page_id0, page_id1;
+  Page *page0 = bpm.NewPageGuarded(page_id0).GetPage();
+  Page *page1 = bpm.NewPageGuarded(page_id1).GetPage();
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  WritePageGuard guard0 = bpm.FetchPageWrite(page_id0);
+  guard0.MarkDirty();
+  WritePageGuard moved(std::move(guard0));
+  EXPECT_EQ(false, guard0.IsValid());
+  EXPECT_EQ(false, guard0.IsDirty());
+  EXPECT_EQ(true, moved.IsDirty());
+  EXPECT_EQ(page0, moved.GetPage());
+  EXPECT_EQ(1, page0->GetPinCount());
+
+  // assigning releases the page held before
+  WritePageGuard guard1 = bpm.FetchPageWrite(page_id1);
+  moved = std::move(guard1);
+  EXPECT_EQ(0, page0->GetPinCount());
+  EXPECT_EQ(1, page1->GetPinCount());
+  EXPECT_EQ(page1, moved.GetPage());
+  EXPECT_EQ(false, guard1.IsValid());
+
+  // a moved-from guard can be reused
+  guard0 = bpm.FetchPageWrite(page_id0);
+  EXPECT_EQ(1, page0->GetPinCount());
+  guard0.Release();
+  moved.Release();
+  EXPECT_EQ(0, page0->GetPinCount());
+  EXPECT_EQ(0, page1->GetPinCount());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(PageGuardTest, ReleaseTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(1, disk_manager);
+  page_id_t page_id0, page_id1;
+  {
+    WritePageGuard guard = bpm.NewPageGuarded(page_id0);
+    strcpy(guard.GetData(), "page 0");
+    guard.Release();
+    EXPECT_EQ(false, guard.IsValid());
+    // a second release and the destructor do not unpin again
+    guard.Release();
+  }
+  {
+    // another pin on the page must survive the stale guard
+    ReadPageGuard guard = bpm.FetchPageRead(page_id0);
+    Page *page = bpm.FetchPage(page_id0);
+    EXPECT_EQ(2, page->GetPinCount());
+    guard.Release();
+    guard.Release();
+    EXPECT_EQ(1, page->GetPinCount());
+    // fully pinned pool: the guard comes back empty
+    EXPECT_EQ(false, bpm.NewPageGuarded(page_id1).IsValid());
+    EXPECT_EQ(true, bpm.UnpinPage(page_id0, false));
+  }
+  // the only frame is taken over, the dirty page 0 went to disk
+  {
+    WritePageGuard guard = bpm.NewPageGuarded(page_id1);
+    ASSERT_EQ(true, guard.IsValid());
+  }
+  ReadPageGuard guard = bpm.FetchPageRead(page_id0);
+  ASSERT_EQ(true, guard.IsValid());
+  EXPECT_EQ(0, strcmp(guard.GetData(), "page 0"));
+  guard.Release();
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -0,0 +1,69 @@
+/**
+ * lz77_test.cpp
+ */
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/lz77.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// compress and inflate data, return the compressed size
+size_t RoundTrip(const std::vector<char> &data) {
+  std::vector<char> compressed;
+  size_t size = LZ77::Compress(data.data(), data.size(), compressed);
+  EXPECT_EQ(size, compressed.size());
+  EXPECT_LE(size, LZ77::MaxCompressedSize(data.size()));
+  std::vector<char> inflated(data.size());
+  EXPECT_EQ(true, LZ77::Decompress(compressed.data(), compressed.size(),
+                                   inflated.data(), inflated.size()));
+  EXPECT_EQ(0, memcmp(data.data(), inflated.data(), data.size()));
+  return size;
+}
+
+TEST(LZ77Test, RoundTripTest) {
+  std::mt19937 gen(0);
+  // a mostly empty page: a few records and zero padding
+  std::vector<char> page(4096, 0);
+  for (int i = 0; i < 40; i++) {
+    std::string record = "key " + std::to_string(i) + " value " + std::to_string(i * 7);
+    memcpy(page.data() + i * 32, record.c_str(), record.size());
+  }
+  EXPECT_LT(RoundTrip(page), page.size() / 4);
+
+  // long runs need extended lengths
+  std::vector<char> zeros(65536, 0);
+  EXPECT_LT(RoundTrip(zeros), 512);
+
+  // random bytes do not compress, but survive
+  std::vector<char> noise(4096);
+  for (auto &c : noise) {
+    c = static_cast<char>(gen());
+  }
+  RoundTrip(noise);
+
+  // tiny and empty inputs are literals only
+  RoundTrip(std::vector<char>{'a', 'b', 'c'});
+  RoundTrip(std::vector<char>{});
+}
+
+TEST(LZ77Test, CorruptInputTest) {
+  std::vector<char> page(512, 'x');
+  std::vector<char> compressed;
+  LZ77::Compress(page.data(), page.size(), compressed);
+  std::vector<char> inflated(page.size());
+  // truncated blocks and wrong sizes are refused
+  EXPECT_EQ(false, LZ77::Decompress(compressed.data(), compressed.size() - 2,
+                                    inflated.data(), inflated.size()));
+  EXPECT_EQ(false, LZ77::Decompress(compressed.data(), compressed.size(),
+                                    inflated.data(), inflated.size() - 1));
+  // an offset pointing before the output
+  char bad[] = {0x10, 'a', 0x05, 0x00};
+  EXPECT_EQ(false, LZ77::Decompress(bad, sizeof(bad), inflated.data(), 5));
+}
+
+} // namespace cmudb
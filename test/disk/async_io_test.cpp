@@ -0,0 +1,201 @@
+/**
+ * async_io_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+namespace {
+void ReadWriteRoundTrip(DiskManager *disk_manager, AsyncIO *io) {
+  const int num_pages = 100;
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<AsyncIOCompletion> completions;
+  for (int i = 0; i < num_pages; i++) {
+    snprintf(pages[i].data(), PAGE_SIZE, "async page %d", i);
+    while (!io->PrepareWrite(i, pages[i].data(), i)) {
+      io->Reap(completions, 1);
+    }
+  }
+  io->Reap(completions, io->GetInFlight());
+  ASSERT_EQ(static_cast<size_t>(num_pages), completions.size());
+  for (auto &completion : completions) {
+    EXPECT_EQ(true, completion.ok);
+    EXPECT_EQ(true, completion.is_write);
+    EXPECT_EQ(completion.page_id, static_cast<page_id_t>(completion.tag));
+  }
+
+  // the synchronous path sees the pages
+  std::vector<char> buffer(PAGE_SIZE);
+  disk_manager->ReadPage(42, buffer.data());
+  EXPECT_EQ(0, strcmp(buffer.data(), "async page 42"));
+
+  // read them back in reverse, one past the end of the file reads as zeros
+  for (auto &page : pages) {
+    memset(page.data(), 1, PAGE_SIZE);
+  }
+  std::vector<char> beyond(PAGE_SIZE, 1);
+  completions.clear();
+  ASSERT_EQ(true, io->PrepareRead(num_pages, beyond.data(), num_pages));
+  for (int i = num_pages - 1; i >= 0; i--) {
+    while (!io->PrepareRead(i, pages[i].data(), i)) {
+      io->Reap(completions, 1);
+    }
+  }
+  io->Reap(completions, io->GetInFlight());
+  EXPECT_EQ(0u, io->GetInFlight());
+  ASSERT_EQ(static_cast<size_t>(num_pages + 1), completions.size());
+  char expected[32];
+  for (int i = 0; i < num_pages; i++) {
+    snprintf(expected, sizeof(expected), "async page %d", i);
+    EXPECT_EQ(0, strcmp(expected, pages[i].data()));
+  }
+  for (char c : beyond) {
+    ASSERT_EQ(0, c);
+  }
+}
+} // namespace
+
+TEST(AsyncIOTest, IoUringTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  AsyncIO *io = disk_manager->NewAsyncIO(8, AsyncIOType::IO_URING);
+  if (io == nullptr) {
+    std::cout << "io_uring not available, skipped" << std::endl;
+  } else {
+    EXPECT_EQ(AsyncIOType::IO_URING, io->GetType());
+    EXPECT_EQ(8u, io->GetDepth());
+    ReadWriteRoundTrip(disk_manager, io);
+    delete io;
+  }
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(AsyncIOTest, ThreadPoolTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  AsyncIO *io = disk_manager->NewAsyncIO(8, AsyncIOType::THREAD_POOL);
+  ASSERT_NE(nullptr, io);
+  EXPECT_EQ(AsyncIOType::THREAD_POOL, io->GetType());
+  ReadWriteRoundTrip(disk_manager, io);
+  delete io;
+
+  EXPECT_EQ(nullptr, disk_manager->NewAsyncIO(0));
+  // AUTO always finds a backend
+  io = disk_manager->NewAsyncIO(4);
+  ASSERT_NE(nullptr, io);
+  delete io;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(AsyncIOTest, BufferPoolTest) {
+  const size_t saved_depth = ASYNC_IO_DEPTH;
+  const int num_pages = 64;
+  page_id_t temp_page_id;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  {
+    BufferPoolManager bpm(num_pages, disk_manager);
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+    }
+    // the flush thread writes the dirty pages through its AsyncIO
+    bpm.RunFlushThread(std::chrono::milliseconds(1));
+    for (int tries = 0; tries < 1000 && bpm.GetBackgroundWriteCount() <
+                                            static_cast<uint64_t>(num_pages);
+         tries++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    bpm.StopFlushThread();
+    EXPECT_EQ(static_cast<uint64_t>(num_pages), bpm.GetBackgroundWriteCount());
+  }
+  for (size_t depth : {size_t(0), size_t(16)}) {
+    ASYNC_IO_DEPTH = depth;
+    BufferPoolManager bpm(num_pages, disk_manager);
+    bpm.PrefetchPages(0, num_pages);
+    for (int tries = 0; tries < 1000 && bpm.GetPrefetchCount() <
+                                            static_cast<uint64_t>(num_pages / 2);
+         tries++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // the queue holds half the pool
+    EXPECT_EQ(static_cast<uint64_t>(num_pages / 2), bpm.GetPrefetchCount());
+    char expected[32];
+    for (int i = 0; i < num_pages / 2; i++) {
+      Page *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, sizeof(expected), "page %d", i);
+      EXPECT_EQ(0, strcmp(expected, page->GetData()));
+      bpm.UnpinPage(i, false);
+    }
+    BufferPoolStats stats = bpm.GetStats();
+    EXPECT_EQ(0u, stats.misses);
+  }
+  ASYNC_IO_DEPTH = saved_depth;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(AsyncIOTest, RandomReadBenchmark) {
+  const int num_pages = 2048;
+  const int num_reads = 20000;
+  const size_t depth = 32;
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
+  std::vector<char> data(4096, 0);
+  for (int i = 0; i < num_pages; i++) {
+    snprintf(data.data(), data.size(), "page %d", i);
+    disk_manager->WritePage(i, data.data());
+  }
+  std::vector<std::vector<char>> buffers(depth, std::vector<char>(4096));
+  std::vector<AsyncIOCompletion> completions;
+
+  std::mt19937 rng(0);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_reads; i++) {
+    disk_manager->ReadPage(rng() % num_pages, buffers[0].data());
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "synchronous: " << elapsed.count() << " us" << std::endl;
+
+  for (AsyncIOType type : {AsyncIOType::IO_URING, AsyncIOType::THREAD_POOL}) {
+    AsyncIO *io = disk_manager->NewAsyncIO(depth, type);
+    if (io == nullptr) {
+      continue;
+    }
+    rng.seed(0);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_reads; i += depth) {
+      for (size_t k = 0; k < depth; k++) {
+        EXPECT_EQ(true, io->PrepareRead(rng() % num_pages, buffers[k].data(), k));
+      }
+      completions.clear();
+      io->Reap(completions, depth);
+    }
+    elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << (type == AsyncIOType::IO_URING ? "io_uring: " : "thread pool: ")
+              << elapsed.count() << " us, depth " << depth << std::endl;
+    delete io;
+  }
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
@@ -0,0 +1,565 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+#include "page/header_page.h"
+
+namespace cmudb {
+
+TEST(DiskManagerTest, ReadWriteTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<char> data(PAGE_SIZE, 0);
+  std::vector<char> buffer(PAGE_SIZE, 1);
+  strcpy(data.data(), "page 3");
+  disk_manager->WritePage(3, data.data());
+  disk_manager->ReadPage(3, buffer.data());
+  EXPECT_EQ(0, memcmp(data.data(), buffer.data(), PAGE_SIZE));
+  // the hole before page 3 reads as zeros
+  memset(buffer.data(), 1, PAGE_SIZE);
+  disk_manager->ReadPage(1, buffer.data());
+  for (char c : buffer) {
+    ASSERT_EQ(0, c);
+  }
+
+  // a batch with two runs of consecutive pages
+  std::vector<std::vector<char>> pages(5, std::vector<char>(PAGE_SIZE, 0));
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  for (page_id_t page_id : {4, 5, 6, 9, 10}) {
+    auto &page = pages[batch.size()];
+    snprintf(page.data(), PAGE_SIZE, "batch page %d", page_id);
+    batch.push_back({page_id, page.data()});
+  }
+  disk_manager->WritePages(batch);
+  for (auto &page : batch) {
+    disk_manager->ReadPage(page.first, buffer.data());
+    EXPECT_EQ(0, memcmp(page.second, buffer.data(), PAGE_SIZE));
+  }
+  EXPECT_EQ(true, disk_manager->SyncPages());
+  delete disk_manager;
+  // a file name without extension opens no database file
+  disk_manager = new DiskManager("test");
+  EXPECT_EQ(false, disk_manager->SyncPages());
+  delete disk_manager;
+
+  // the pages are still there after reopening the file
+  disk_manager = new DiskManager("test.db");
+  disk_manager->ReadPage(3, buffer.data());
+  EXPECT_EQ(0, strcmp(buffer.data(), "page 3"));
+  disk_manager->ReadPage(10, buffer.data());
+  EXPECT_EQ(0, strcmp(buffer.data(), "batch page 10"));
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, FileSizeTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(0u, disk_manager->GetDbFileSize());
+  std::vector<char> data(PAGE_SIZE * 2, 0);
+  disk_manager->WritePage(2, data.data());
+  EXPECT_EQ(3u * PAGE_SIZE, disk_manager->GetDbFileSize());
+  // writing inside the file does not move the end
+  disk_manager->WritePage(0, data.data());
+  EXPECT_EQ(3u * PAGE_SIZE, disk_manager->GetDbFileSize());
+  disk_manager->WritePages({{4, data.data()}, {5, data.data() + PAGE_SIZE}});
+  EXPECT_EQ(6u * PAGE_SIZE, disk_manager->GetDbFileSize());
+
+  AsyncIO *io = disk_manager->NewAsyncIO(1);
+  ASSERT_NE(nullptr, io);
+  ASSERT_EQ(true, io->PrepareWrite(9, data.data(), 0));
+  std::vector<AsyncIOCompletion> completions;
+  io->Reap(completions, 1);
+  delete io;
+  EXPECT_EQ(10u * PAGE_SIZE, disk_manager->GetDbFileSize());
+
+  // a page written asynchronously reads back, past the end reads nothing
+  data[0] = 'x';
+  disk_manager->ReadPage(9, data.data());
+  EXPECT_EQ(0, data[0]);
+  data[0] = 'x';
+  disk_manager->ReadPage(11, data.data());
+  EXPECT_EQ('x', data[0]);
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(10u * PAGE_SIZE, disk_manager->GetDbFileSize());
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+namespace {
+// what a checkpoint that synced every page does to the deallocated pages
+void Checkpoint(DiskManager *disk_manager) {
+  disk_manager->FreeDeallocatedPages(disk_manager->TakeDeallocatedPages(),
+                                     true);
+}
+} // namespace
+
+TEST(DiskManagerTest, FreeMapTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<char> data(PAGE_SIZE, 0);
+  for (page_id_t i = 0; i < 10; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    disk_manager->WritePage(i, data.data());
+  }
+  // the first page freed becomes the free map page and is not reused
+  disk_manager->DeallocatePage(3);
+  Checkpoint(disk_manager);
+  EXPECT_EQ(0u, disk_manager->GetFreePageCount());
+  disk_manager->DeallocatePage(2);
+  disk_manager->DeallocatePage(5);
+  disk_manager->DeallocatePage(6);
+  disk_manager->DeallocatePage(6);
+  disk_manager->DeallocatePage(HEADER_PAGE_ID);
+  disk_manager->DeallocatePage(3);
+  disk_manager->DeallocatePage(42);
+  // nothing is free before a checkpoint made it safe
+  EXPECT_EQ(0u, disk_manager->GetFreePageCount());
+  std::vector<page_id_t> deallocated = disk_manager->TakeDeallocatedPages();
+  EXPECT_EQ(3u, deallocated.size());
+  disk_manager->FreeDeallocatedPages(deallocated, false);
+  EXPECT_EQ(0u, disk_manager->GetFreePageCount());
+  Checkpoint(disk_manager);
+  EXPECT_EQ(3u, disk_manager->GetFreePageCount());
+
+  // closest to the hint first, the lowest without one
+  EXPECT_EQ(6, disk_manager->AllocatePage(8));
+  EXPECT_EQ(2, disk_manager->AllocatePage());
+  EXPECT_EQ(5, disk_manager->AllocatePage(1));
+  EXPECT_EQ(10, disk_manager->AllocatePage());
+  disk_manager->WritePage(10, data.data());
+
+  // freeing the last page shrinks the file, with the free pages before it
+  disk_manager->DeallocatePage(8);
+  disk_manager->DeallocatePage(9);
+  Checkpoint(disk_manager);
+  EXPECT_EQ(2u, disk_manager->GetFreePageCount());
+  disk_manager->DeallocatePage(10);
+  Checkpoint(disk_manager);
+  EXPECT_EQ(0u, disk_manager->GetFreePageCount());
+  EXPECT_EQ(8, disk_manager->GetNextPageId());
+  EXPECT_EQ(8u * PAGE_SIZE, disk_manager->GetDbFileSize());
+  struct stat st;
+  ASSERT_EQ(0, stat("test.db", &st));
+  EXPECT_EQ(static_cast<off_t>(8 * PAGE_SIZE), st.st_size);
+  EXPECT_EQ(8, disk_manager->AllocatePage());
+  // a page nobody has seen is freed right away
+  disk_manager->DeallocatePage(8, false);
+  EXPECT_EQ(8, disk_manager->GetNextPageId());
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, FreeMapPersistTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<char> header(PAGE_SIZE);
+  std::vector<char> data(PAGE_SIZE, 0);
+  EXPECT_EQ(HEADER_PAGE_ID, disk_manager->AllocatePage());
+  HeaderPage::Format(header.data(), PAGE_SIZE);
+  disk_manager->WritePage(HEADER_PAGE_ID, header.data());
+  for (page_id_t i = 1; i < 10; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    disk_manager->WritePage(i, data.data());
+  }
+  disk_manager->DeallocatePage(3);
+  Checkpoint(disk_manager);
+  disk_manager->DeallocatePage(5);
+  disk_manager->DeallocatePage(6);
+  Checkpoint(disk_manager);
+  // the buffer pool's copy of the header page knows nothing of the free map
+  disk_manager->WritePage(HEADER_PAGE_ID, header.data());
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  disk_manager->ReadPage(HEADER_PAGE_ID, header.data());
+  EXPECT_EQ(3, HeaderPage::ReadFreeMapPageId(header.data(), PAGE_SIZE));
+  EXPECT_EQ(10, disk_manager->GetNextPageId());
+  EXPECT_EQ(2u, disk_manager->GetFreePageCount());
+  EXPECT_EQ(6, disk_manager->AllocatePage(7));
+  delete disk_manager;
+
+  // the allocation above reached the disk too
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(1u, disk_manager->GetFreePageCount());
+  EXPECT_EQ(5, disk_manager->AllocatePage());
+  EXPECT_EQ(10, disk_manager->AllocatePage());
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+/**
+ * create and delete pages through the buffer pool in rounds, keeping about
+ * live_pages of them. Without reuse the file grows by every page created
+ */
+TEST(DiskManagerTest, ChurnBenchmark) {
+  const int live_pages = 1000;
+  const int rounds = 50;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<page_id_t> live;
+  size_t created = 0;
+  std::mt19937 rng(0);
+  {
+    BufferPoolManager bpm(64, disk_manager);
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    bpm.UnpinPage(page_id, true);
+    for (int round = 0; round < rounds; round++) {
+      while (live.size() < static_cast<size_t>(live_pages)) {
+        page = bpm.NewPage(page_id, live.empty() ? INVALID_PAGE_ID : live.back());
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+        bpm.UnpinPage(page_id, true);
+        live.push_back(page_id);
+        created++;
+      }
+      // delete a random half
+      std::shuffle(live.begin(), live.end(), rng);
+      for (int i = 0; i < live_pages / 2; i++) {
+        EXPECT_EQ(true, bpm.DeletePage(live.back()));
+        live.pop_back();
+      }
+      // the deleted pages become free
+      EXPECT_EQ(true, bpm.FlushAllPages().synced);
+    }
+  }
+  std::cout << "pages created: " << created << ", live: " << live.size()
+            << ", file: " << disk_manager->GetDbFileSize() / PAGE_SIZE
+            << " pages" << std::endl;
+  // live pages, free pages and free map pages, which are a few per range
+  EXPECT_LT(disk_manager->GetDbFileSize() / PAGE_SIZE,
+            static_cast<uint64_t>(live_pages * 2));
+  EXPECT_GT(created, static_cast<size_t>(live_pages * 10));
+  // the pages that stayed are intact
+  std::vector<char> data(PAGE_SIZE);
+  char expected[32];
+  for (page_id_t page_id : live) {
+    disk_manager->ReadPage(page_id, data.data());
+    snprintf(expected, sizeof(expected), "page %d", page_id);
+    EXPECT_EQ(0, strcmp(expected, data.data()));
+  }
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, ConcurrentTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 16;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([disk_manager, tid] {
+      std::vector<char> data(PAGE_SIZE);
+      std::vector<char> buffer(PAGE_SIZE);
+      for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          // each thread owns its pages, interleaved with the other threads
+          page_id_t page_id = i * num_threads + tid;
+          memset(data.data(), tid * 16 + round % 16, PAGE_SIZE);
+          disk_manager->WritePage(page_id, data.data());
+          disk_manager->ReadPage(page_id, buffer.data());
+          ASSERT_EQ(0, memcmp(data.data(), buffer.data(), PAGE_SIZE));
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, RandomReadBenchmark) {
+  const int num_pages = 1024;
+  const int reads_per_thread = 20000;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<char> data(PAGE_SIZE, 0);
+  for (int i = 0; i < num_pages; i++) {
+    snprintf(data.data(), PAGE_SIZE, "page %d", i);
+    disk_manager->WritePage(i, data.data());
+  }
+
+  // the previous backend: one fstream whose cursor every reader shares
+  std::fstream stream("test.db", std::ios::binary | std::ios::in);
+  std::mutex stream_latch;
+  auto read_stream = [&](page_id_t page_id, char *page_data) {
+    std::lock_guard<std::mutex> guard(stream_latch);
+    stream.seekg(static_cast<size_t>(page_id) * PAGE_SIZE);
+    stream.read(page_data, PAGE_SIZE);
+  };
+  auto read_pread = [&](page_id_t page_id, char *page_data) {
+    disk_manager->ReadPage(page_id, page_data);
+  };
+
+  for (int num_threads : {1, 4, 8}) {
+    for (int backend = 0; backend < 2; backend++) {
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (int tid = 0; tid < num_threads; tid++) {
+        threads.push_back(std::thread([&, tid] {
+          std::mt19937 rng(tid);
+          std::vector<char> buffer(PAGE_SIZE);
+          char expected[32];
+          for (int i = 0; i < reads_per_thread; i++) {
+            page_id_t page_id = rng() % num_pages;
+            if (backend == 0) {
+              read_stream(page_id, buffer.data());
+            } else {
+              read_pread(page_id, buffer.data());
+            }
+            snprintf(expected, sizeof(expected), "page %d", page_id);
+            ASSERT_EQ(0, strcmp(expected, buffer.data()));
+          }
+        }));
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start);
+      std::cout << (backend == 0 ? "fstream: " : "pread: ") << num_threads
+                << " threads, " << elapsed.count() << " us" << std::endl;
+    }
+  }
+  stream.close();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, DirectIOTest) {
+  const size_t page_size = 4096;
+  DISK_DIRECT_IO = true;
+  DiskManager *disk_manager = new DiskManager("test.db", page_size);
+  DISK_DIRECT_IO = false;
+  if (disk_manager->GetDirectIOAlignment() == 0) {
+    std::cout << "no O_DIRECT on this file system, skipped" << std::endl;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+    return;
+  }
+  EXPECT_EQ(0u, page_size % disk_manager->GetDirectIOAlignment());
+
+  // unaligned buffers go through a bounce buffer
+  std::vector<char> unaligned(page_size * 3 + 1, 0);
+  char *page0 = unaligned.data() + 1;
+  strcpy(page0, "unaligned page");
+  disk_manager->WritePage(1, page0);
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  strcpy(page0 + page_size, "batch page 2");
+  strcpy(page0 + 2 * page_size, "batch page 3");
+  batch.push_back({2, page0 + page_size});
+  batch.push_back({3, page0 + 2 * page_size});
+  disk_manager->WritePages(batch);
+
+  char *aligned = nullptr;
+  ASSERT_EQ(0, posix_memalign(reinterpret_cast<void **>(&aligned), page_size,
+                              2 * page_size));
+  disk_manager->ReadPage(1, aligned);
+  EXPECT_EQ(0, strcmp(aligned, "unaligned page"));
+  disk_manager->ReadPage(3, page0);
+  EXPECT_EQ(0, strcmp(page0, "batch page 3"));
+  // the page past the end of the file reads as zeros either way
+  disk_manager->ReadPage(4, page0);
+  EXPECT_EQ(0, page0[0]);
+
+  // asynchronous I/O with aligned buffers
+  AsyncIO *io = disk_manager->NewAsyncIO(2);
+  ASSERT_NE(nullptr, io);
+  strcpy(aligned + page_size, "async page 5");
+  ASSERT_EQ(true, io->PrepareWrite(5, aligned + page_size, 0));
+  std::vector<AsyncIOCompletion> completions;
+  io->Reap(completions, 1);
+  ASSERT_EQ(1u, completions.size());
+  EXPECT_EQ(true, completions[0].ok);
+  ASSERT_EQ(true, io->PrepareRead(2, aligned, 0));
+  io->Reap(completions, 1);
+  EXPECT_EQ(true, completions[1].ok);
+  EXPECT_EQ(0, strcmp(aligned, "batch page 2"));
+  delete io;
+  free(aligned);
+
+  // frames of the buffer pool are aligned
+  {
+    BufferPoolManager bpm(4, disk_manager);
+    Page *page = bpm.FetchPage(5);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), "async page 5"));
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(page->GetData()) %
+                      disk_manager->GetDirectIOAlignment());
+    bpm.UnpinPage(5, false);
+  }
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+namespace {
+// read syscalls (read, pread, readv, ...) made by this process so far
+uint64_t ReadSyscalls() {
+  std::ifstream io("/proc/self/io");
+  std::string key;
+  uint64_t value = 0;
+  while (io >> key >> value) {
+    if (key == "syscr:") {
+      return value;
+    }
+  }
+  return 0;
+}
+} // namespace
+
+// ReadPage costs one pread: the file size is tracked in memory instead of
+// being stat()ed on every call as it used to be
+TEST(DiskManagerTest, ReadSyscallBenchmark) {
+  const int num_pages = 256;
+  const int num_reads = 100000;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<char> data(PAGE_SIZE, 0);
+  for (int i = 0; i < num_pages; i++) {
+    disk_manager->WritePage(i, data.data());
+  }
+  // what it costs to look at the counter itself
+  uint64_t overhead = ReadSyscalls();
+  overhead = ReadSyscalls() - overhead;
+
+  uint64_t before = ReadSyscalls();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_reads; i++) {
+    disk_manager->ReadPage(i % num_pages, data.data());
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  uint64_t reads = ReadSyscalls() - before - overhead;
+  // the counter only moves when procfs is there
+  if (before > 0) {
+    EXPECT_EQ(static_cast<uint64_t>(num_reads), reads);
+  }
+
+  // the old path: stat() the file, then read the page
+  struct stat st;
+  int fd = open("test.db", O_RDONLY);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_reads; i++) {
+    stat("test.db", &st);
+    ASSERT_EQ(PAGE_SIZE, pread(fd, data.data(), PAGE_SIZE,
+                               static_cast<off_t>(i % num_pages) * PAGE_SIZE));
+  }
+  auto baseline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  close(fd);
+  std::cout << "ReadPage: " << elapsed.count() / num_reads << " ns, "
+            << static_cast<double>(reads) / num_reads
+            << " read syscalls per call; stat + pread: "
+            << baseline.count() / num_reads << " ns" << std::endl;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+namespace {
+// bytes of the file the OS keeps in its page cache
+size_t CachedBytes(const char *file_name) {
+  int fd = open(file_name, O_RDONLY);
+  struct stat st;
+  fstat(fd, &st);
+  size_t os_page = sysconf(_SC_PAGESIZE);
+  size_t pages = (st.st_size + os_page - 1) / os_page;
+  void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  std::vector<unsigned char> resident(pages);
+  mincore(addr, st.st_size, resident.data());
+  munmap(addr, st.st_size);
+  close(fd);
+  size_t cached = 0;
+  for (unsigned char r : resident) {
+    cached += (r & 1) * os_page;
+  }
+  return cached;
+}
+} // namespace
+
+// random fetches over a file eight times the pool: how much of the file the
+// OS caches next to the pool, and what that costs in throughput
+TEST(DiskManagerTest, DirectIOBenchmark) {
+  const size_t page_size = 4096;
+  const int num_pages = 8192;
+  const size_t pool_size = 1024;
+  const int num_fetches = 20000;
+  for (bool direct : {false, true}) {
+    DISK_DIRECT_IO = direct;
+    DiskManager *disk_manager = new DiskManager("test.db", page_size);
+    DISK_DIRECT_IO = false;
+    if (direct && disk_manager->GetDirectIOAlignment() == 0) {
+      std::cout << "no O_DIRECT on this file system, skipped" << std::endl;
+      delete disk_manager;
+      break;
+    }
+    std::vector<char> data(page_size * 64, 0);
+    std::vector<std::pair<page_id_t, const char *>> batch;
+    for (int i = 0; i < num_pages; i += 64) {
+      batch.clear();
+      for (int k = 0; k < 64; k++) {
+        snprintf(data.data() + k * page_size, page_size, "page %d", i + k);
+        batch.push_back({i + k, data.data() + k * page_size});
+      }
+      disk_manager->WritePages(batch);
+    }
+    // start from a cold OS cache
+    int fd = open("test.db", O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+
+    std::mt19937 rng(0);
+    char expected[32];
+    auto start = std::chrono::steady_clock::now();
+    {
+      BufferPoolManager bpm(pool_size, disk_manager);
+      for (int i = 0; i < num_fetches; i++) {
+        page_id_t page_id = rng() % num_pages;
+        Page *page = bpm.FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(expected, sizeof(expected), "page %d", page_id);
+        ASSERT_EQ(0, strcmp(expected, page->GetData()));
+        bpm.UnpinPage(page_id, false);
+      }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << (direct ? "O_DIRECT: " : "buffered: ") << elapsed.count()
+              << " us, pool " << pool_size * page_size / 1024 << " KB, OS cache "
+              << CachedBytes("test.db") / 1024 << " KB" << std::endl;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,150 @@
+/**
+ * lock_free_hash_table_test.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+#include "common/exception.h"
+#include "hash/extendible_hash.h"
+#include "hash/lock_free_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LockFreeHashTableTest, SampleTest) {
+  LockFreeHashTable<int, int> test(8);
+  EXPECT_EQ(16, test.GetCapacity());
+
+  // insert several key/value pairs
+  for (int i = 0; i < 8; i++) {
+    test.Insert(i, i * 10);
+  }
+  EXPECT_EQ(8, test.GetSize());
+
+  // find test
+  int result;
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ(1, test.Find(i, result));
+    EXPECT_EQ(i * 10, result);
+  }
+  EXPECT_EQ(0, test.Find(8, result));
+
+  // overwrite keeps the size
+  test.Insert(3, 33);
+  EXPECT_EQ(1, test.Find(3, result));
+  EXPECT_EQ(33, result);
+  EXPECT_EQ(8, test.GetSize());
+
+  // delete test, the remaining keys stay reachable
+  EXPECT_EQ(1, test.Remove(3));
+  EXPECT_EQ(0, test.Remove(3));
+  EXPECT_EQ(0, test.Find(3, result));
+  for (int i = 0; i < 8; i++) {
+    if (i != 3) {
+      EXPECT_EQ(1, test.Find(i, result));
+      EXPECT_EQ(i * 10, result);
+    }
+  }
+  EXPECT_EQ(7, test.GetSize());
+}
+
+TEST(LockFreeHashTableTest, ChurnTest) {
+  // keep the table nearly full and cycle through many keys so that long probe
+  // runs are built and torn down by Remove over and over
+  LockFreeHashTable<int, int> test(16);
+  const int live = 30;
+  for (int i = 0; i < live; i++) {
+    test.Insert(i, i);
+  }
+  for (int i = live; i < 5000; i++) {
+    EXPECT_EQ(1, test.Remove(i - live));
+    test.Insert(i, i);
+    int result;
+    for (int j = i - live + 1; j <= i; j++) {
+      ASSERT_EQ(1, test.Find(j, result));
+      ASSERT_EQ(j, result);
+    }
+    EXPECT_EQ(0, test.Find(i - live, result));
+  }
+  EXPECT_EQ(live, test.GetSize());
+
+  // one slot always stays empty
+  LockFreeHashTable<int, int> full(1);
+  full.Insert(1, 1);
+  EXPECT_THROW(full.Insert(2, 2), Exception);
+}
+
+TEST(LockFreeHashTableTest, ConcurrentFindTest) {
+  const int num_stable = 64;
+  const int num_readers = 3;
+  LockFreeHashTable<int, int> test(128);
+  for (int i = 0; i < num_stable; i++) {
+    test.Insert(i, i);
+  }
+
+  // readers must always see the stable keys while a writer churns others
+  std::atomic<bool> done(false);
+  std::atomic<int> errors(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_readers; t++) {
+    threads.push_back(std::thread([&test, &done, &errors] {
+      int result;
+      while (!done) {
+        for (int i = 0; i < num_stable; i++) {
+          if (!test.Find(i, result) || result != i) {
+            errors++;
+          }
+        }
+      }
+    }));
+  }
+  for (int i = 0; i < 20000; i++) {
+    int key = num_stable + i % 64;
+    test.Insert(key, key);
+    test.Remove(key);
+  }
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, errors);
+}
+
+// cost of the page table lookup on a buffer pool hit
+template <typename TableT>
+double FindNanos(TableT &table, int num_keys, int rounds) {
+  for (int i = 0; i < num_keys; i++) {
+    table.Insert(i, i);
+  }
+  int result = 0;
+  long long sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < num_keys; i++) {
+      table.Find((i * 7 + r) % num_keys, result);
+      sum += result;
+    }
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  EXPECT_GT(sum, 0);
+  return elapsed.count() / (static_cast<double>(rounds) * num_keys);
+}
+
+TEST(LockFreeHashTableTest, FindBenchmark) {
+  const int num_keys = 1024;
+  const int rounds = 500;
+  ExtendibleHash<int, int> extendible(BUCKET_SIZE);
+  LockFreeHashTable<int, int> lock_free(num_keys);
+  double extendible_ns = FindNanos(extendible, num_keys, rounds);
+  double lock_free_ns = FindNanos(lock_free, num_keys, rounds);
+  std::cout << "find ns/op: extendible=" << extendible_ns
+            << " lock_free=" << lock_free_ns << std::endl;
+}
+
+} // namespace cmudb
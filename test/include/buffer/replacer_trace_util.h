@@ -0,0 +1,106 @@
+/**
+ * replacer_trace_util.h
+ *
+ * Trace replay harness for replacers: simulates a buffer pool of a given
+ * capacity on top of a Replacer<int> keyed by page id and counts hits.
+ */
+
+#pragma once
+
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+struct TraceResult {
+  size_t hits = 0;
+  size_t accesses = 0;
+  // hits/accesses restricted to the pages passed as "tracked"
+  size_t tracked_hits = 0;
+  size_t tracked_accesses = 0;
+
+  double HitRate() const {
+    return accesses == 0 ? 0 : static_cast<double>(hits) / accesses;
+  }
+  double TrackedHitRate() const {
+    return tracked_accesses == 0
+               ? 0
+               : static_cast<double>(tracked_hits) / tracked_accesses;
+  }
+};
+
+// every access behaves like FetchPage + UnpinPage: a hit pins (Erase) the
+// page, a miss evicts a victim when the pool is full, and the unpin hands
+// the page back to the replacer (Insert)
+TraceResult ReplayTrace(Replacer<int> &replacer, size_t capacity,
+                        const std::vector<int> &trace,
+                        const std::set<int> &tracked = std::set<int>()) {
+  TraceResult result;
+  std::unordered_set<int> resident;
+  for (int page_id : trace) {
+    bool is_tracked = tracked.count(page_id) > 0;
+    result.accesses++;
+    result.tracked_accesses += is_tracked;
+    if (resident.count(page_id) > 0) {
+      result.hits++;
+      result.tracked_hits += is_tracked;
+      replacer.Erase(page_id);
+    } else {
+      if (resident.size() >= capacity) {
+        int victim;
+        if (!replacer.Victim(victim)) {
+          continue;
+        }
+        resident.erase(victim);
+      }
+      resident.insert(page_id);
+    }
+    replacer.Insert(page_id);
+  }
+  return result;
+}
+
+// hot "index" pages [0, num_hot) are looked up between sequential runs over
+// cold "table" pages [num_hot, num_hot + num_cold)
+std::vector<int> MixedScanTrace(int num_hot, int num_cold, int rounds,
+                                int lookups_per_round, int scan_per_round) {
+  std::vector<int> trace;
+  int scan_cursor = 0;
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < lookups_per_round; i++) {
+      trace.push_back((r * 31 + i * 7) % num_hot);
+    }
+    for (int i = 0; i < scan_per_round; i++) {
+      trace.push_back(num_hot + scan_cursor);
+      scan_cursor = (scan_cursor + 1) % num_cold;
+    }
+  }
+  return trace;
+}
+
+// phases of skewed lookups over a hot working set alternate with bursts of
+// sequential reads over table pages, like index traffic mixed with vtable scans
+std::vector<int> ShiftingTrace(int num_hot, int num_cold, int phases,
+                               int lookups_per_phase, int scan_per_phase) {
+  std::vector<int> trace;
+  unsigned int seed = 15445;
+  int scan_cursor = 0;
+  for (int phase = 0; phase < phases; phase++) {
+    for (int i = 0; i < lookups_per_phase; i++) {
+      seed = seed * 1103515245 + 12345;
+      // a quarter of the hot set receives most of the lookups
+      int range = (seed >> 16) % 4 == 0 ? num_hot : num_hot / 4;
+      trace.push_back((seed >> 8) % range);
+    }
+    for (int i = 0; i < scan_per_phase; i++) {
+      trace.push_back(num_hot + scan_cursor);
+      scan_cursor = (scan_cursor + 1) % num_cold;
+    }
+  }
+  return trace;
+}
+
+} // namespace cmudb
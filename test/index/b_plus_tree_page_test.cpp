@@ -0,0 +1,49 @@
+/**
+ * b_plus_tree_page_test.cpp
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "index/b_plus_tree.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// fanout of leaf and internal pages and the height an index over a million
+// keys needs, for every supported page size
+TEST(BPlusTreePageTests, PageSizeFanoutTest) {
+  const long num_keys = 1000000;
+  int last_leaf_max = 0;
+  for (size_t page_size : {512, 4096, 8192, 16384, 65536}) {
+    std::vector<char> data(page_size);
+    auto *leaf = reinterpret_cast<
+        BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *>(
+        data.data());
+    leaf->Init(1, INVALID_PAGE_ID, page_size);
+    int leaf_max = leaf->GetMaxSize();
+    EXPECT_EQ(1, leaf->GetPageId());
+    auto *internal = reinterpret_cast<
+        BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>> *>(
+        data.data());
+    internal->Init(2, INVALID_PAGE_ID, page_size);
+    int internal_max = internal->GetMaxSize();
+    EXPECT_EQ(2, internal->GetPageId());
+    EXPECT_GT(leaf_max, last_leaf_max);
+    last_leaf_max = leaf_max;
+
+    // pages half full, the minimum the tree maintains
+    int height = 1;
+    long pages = (num_keys + leaf_max / 2 - 1) / (leaf_max / 2);
+    while (pages > 1) {
+      pages = (pages + internal_max / 2 - 1) / (internal_max / 2);
+      height++;
+    }
+    std::cout << "page size " << page_size << ": leaf fanout " << leaf_max
+              << ", internal fanout " << internal_max << ", height for "
+              << num_keys << " keys <= " << height << std::endl;
+  }
+}
+
+} // namespace cmudb
@@ -1,16 +1,17 @@
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
-// NOTE: when you running this test, make sure page size(config.h) is at least
-// 4096
 namespace cmudb {
 
 TEST(HeaderPageTest, UnitTest) {
-  DiskManager *disk_manager = new DiskManager("test.db");
+  // 27 records need more than the default page size
+  DiskManager *disk_manager = new DiskManager("test.db", 4096);
   BufferPoolManager *buffer_pool_manager =
       new BufferPoolManager(20, disk_manager);
   page_id_t header_page_id;
@@ -55,4 +56,102 @@ TEST(HeaderPageTest, UnitTest) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(HeaderPageTest, PageSizeTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db", 8192);
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(20, disk_manager);
+  EXPECT_EQ(8192, buffer_pool_manager->GetPageSize());
+  page_id_t header_page_id;
+  HeaderPage *page =
+      static_cast<HeaderPage *>(buffer_pool_manager->NewPage(header_page_id));
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(8192, page->GetPageSize());
+  EXPECT_EQ(true, page->InsertRecord("table", 1));
+  // the whole page is usable: (8192 - 16) / 36 records
+  for (int i = 1; i < 227; i++) {
+    EXPECT_EQ(true, page->InsertRecord(std::to_string(i), i + 1));
+  }
+  EXPECT_EQ(false, page->InsertRecord("full", 1));
+  buffer_pool_manager->UnpinPage(header_page_id, true);
+  buffer_pool_manager->FlushPage(header_page_id);
+  delete buffer_pool_manager;
+  delete disk_manager;
+
+  // reopening the file ignores the requested size
+  disk_manager = new DiskManager("test.db", 512);
+  EXPECT_EQ(8192, disk_manager->GetPageSize());
+  buffer_pool_manager = new BufferPoolManager(20, disk_manager);
+  page = static_cast<HeaderPage *>(
+      buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+  ASSERT_NE(nullptr, page);
+  page_id_t root_id;
+  EXPECT_EQ(true, page->GetRootId("table", root_id));
+  EXPECT_EQ(1, root_id);
+  EXPECT_EQ(true, page->GetRootId("226", root_id));
+  EXPECT_EQ(227, root_id);
+  buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, false);
+  delete buffer_pool_manager;
+  delete disk_manager;
+
+  EXPECT_THROW(DiskManager("bad.db", 3000), Exception);
+  remove("test.db");
+  remove("test.log");
+  remove("bad.log");
+}
+
+// write page 0 of a file by hand
+static void WriteRawHeader(const char *file, const char *data) {
+  FILE *f = fopen(file, "wb");
+  ASSERT_NE(nullptr, f);
+  fwrite(data, 1, PAGE_SIZE, f);
+  fclose(f);
+}
+
+TEST(HeaderPageTest, LegacyFileTest) {
+  // RecordCount at byte 0, entries from byte 4
+  char legacy[PAGE_SIZE] = {0};
+  int record_count = 2;
+  page_id_t root_ids[2] = {3, 5};
+  memcpy(legacy, &record_count, 4);
+  strcpy(legacy + 4, "table");
+  memcpy(legacy + 4 + 32, &root_ids[0], 4);
+  strcpy(legacy + 4 + 36, "index");
+  memcpy(legacy + 4 + 36 + 32, &root_ids[1], 4);
+  WriteRawHeader("test.db", legacy);
+
+  // upgraded on open, the legacy page size wins over the requested one
+  for (int round = 0; round < 2; round++) {
+    DiskManager *disk_manager = new DiskManager("test.db", 4096);
+    EXPECT_EQ(PAGE_SIZE, disk_manager->GetPageSize());
+    BufferPoolManager *buffer_pool_manager =
+        new BufferPoolManager(5, disk_manager);
+    HeaderPage *page = static_cast<HeaderPage *>(
+        buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(2, page->GetRecordCount());
+    page_id_t root_id;
+    EXPECT_EQ(true, page->GetRootId("table", root_id));
+    EXPECT_EQ(3, root_id);
+    EXPECT_EQ(true, page->GetRootId("index", root_id));
+    EXPECT_EQ(5, root_id);
+    buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, false);
+    delete buffer_pool_manager;
+    delete disk_manager;
+  }
+
+  // 14 records fit a legacy page but not the new layout
+  record_count = 14;
+  memcpy(legacy, &record_count, 4);
+  WriteRawHeader("test.db", legacy);
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+
+  // neither a header page nor a legacy one
+  memset(legacy, 0xff, PAGE_SIZE);
+  WriteRawHeader("test.db", legacy);
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+  remove("test.db");
+  remove("test.log");
+}
 } // namespace cmudb
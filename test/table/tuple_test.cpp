@@ -3,6 +3,7 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <iostream>
 #include <string>
@@ -61,4 +62,114 @@ TEST(TupleTest, TableHeapTest) {
   delete disk_manager;
 }
 
+// scan a table that is not cached, once without and once with read-ahead
+TEST(TupleTest, ColdScanBenchmark) {
+  std::string createStmt =
+      "a varchar, b smallint, c bigint, d bool, e varchar(16)";
+  Schema *schema = ParseCreateStatement(createStmt);
+  Tuple tuple = ConstructTuple(schema);
+  const int num_tuples = 5000;
+
+  Transaction *transaction = new Transaction(0);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(50, disk_manager);
+  LockManager *lock_manager = new LockManager(true);
+  TableHeap *table =
+      new TableHeap(buffer_pool_manager, lock_manager, nullptr, transaction);
+  RID rid;
+  for (int i = 0; i < num_tuples; ++i) {
+    table->InsertTuple(tuple, rid, transaction);
+  }
+  page_id_t first_page_id = table->GetFirstPageId();
+  for (page_id_t i = 0; i < disk_manager->GetNextPageId(); ++i) {
+    buffer_pool_manager->FlushPage(i);
+  }
+  delete table;
+  delete buffer_pool_manager;
+
+  for (size_t window : {(size_t)0, (size_t)READ_AHEAD_WINDOW}) {
+    buffer_pool_manager = new BufferPoolManager(16, disk_manager);
+    buffer_pool_manager->SetReadAheadWindow(window);
+    table = new TableHeap(buffer_pool_manager, lock_manager, nullptr,
+                          first_page_id);
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (auto itr = table->begin(transaction); itr != table->end(); ++itr) {
+      ++count;
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    std::cout << "read-ahead window " << window << ": " << count
+              << " tuples in " << ms << " ms, "
+              << buffer_pool_manager->GetPrefetchCount() << " pages prefetched"
+              << std::endl;
+    EXPECT_EQ(num_tuples, count);
+    if (window == 0) {
+      EXPECT_EQ(0, buffer_pool_manager->GetPrefetchCount());
+    }
+    delete table;
+    delete buffer_pool_manager;
+  }
+
+  remove("test.db");
+  remove("test.log");
+  delete schema;
+  delete lock_manager;
+  delete transaction;
+  delete disk_manager;
+}
+
+// insert and scan the same tuples with every supported page size
+TEST(TupleTest, PageSizeScanBenchmark) {
+  std::string createStmt =
+      "a varchar, b smallint, c bigint, d bool, e varchar(16)";
+  Schema *schema = ParseCreateStatement(createStmt);
+  Tuple tuple = ConstructTuple(schema);
+  const int num_tuples = 5000;
+  Transaction *transaction = new Transaction(0);
+  LockManager *lock_manager = new LockManager(true);
+
+  for (size_t page_size : {512, 4096, 8192, 16384, 65536}) {
+    remove("test.db");
+    DiskManager *disk_manager = new DiskManager("test.db", page_size);
+    // same amount of memory for every page size
+    BufferPoolManager *buffer_pool_manager =
+        new BufferPoolManager((1 << 20) / page_size, disk_manager);
+    TableHeap *table =
+        new TableHeap(buffer_pool_manager, lock_manager, nullptr, transaction);
+    RID rid;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_tuples; ++i) {
+      table->InsertTuple(tuple, rid, transaction);
+    }
+    double insert_ms = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (auto itr = table->begin(transaction); itr != table->end(); ++itr) {
+      ++count;
+    }
+    double scan_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    std::cout << "page size " << page_size << ": "
+              << disk_manager->GetNextPageId() << " pages, insert "
+              << insert_ms << " ms, scan " << count / scan_ms
+              << " tuples/ms" << std::endl;
+    EXPECT_EQ(num_tuples, count);
+    delete table;
+    delete buffer_pool_manager;
+    delete disk_manager;
+  }
+
+  remove("test.db");
+  remove("test.log");
+  delete schema;
+  delete lock_manager;
+  delete transaction;
+}
+
 } // namespace cmudb
@@ -35,6 +35,10 @@ TEST(VtableTest, CreateTest) {
   EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo1"));
   EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo1 WHERE b = 2"));
   EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo1"));
+  // buffer pool counters can be queried live
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM bustub_buffer_stats"));
+  EXPECT_TRUE(ExecSQL(
+      db, "SELECT value FROM bustub_buffer_stats WHERE name = 'hits'"));
   EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo1"));
 
   rc = sqlite3_close(db);